@@ -0,0 +1,118 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <vector>
+
+#include "statecache.cpp"
+#include "streambuffer.cpp"
+#include "vertexformat.cpp"
+
+typedef VertexFormat<Float3> BatchVertex;
+
+// Collects triangles from any number of objects into one dynamic vertex
+// buffer and draws them with a single glDrawArrays. A batch is only broken
+// when the program changes or the buffer is full. Vertices are written
+// through the frame's StreamBuffer region, so the caller brackets the frame
+// with stream.beginFrame() / stream.endFrame().
+class BatchRenderer {
+	private:
+		unsigned int VAO;
+		StreamBuffer &stream;
+		unsigned int maxTriangles;
+		unsigned int currentProgram;
+		std::vector<float> vertices;
+		unsigned int drawCalls;
+		unsigned int triangles;
+
+	public:
+		static const int floatsPerTriangle = 9;
+
+		static const int bytesPerTriangle = 3 * BatchVertex::stride;
+
+		BatchRenderer (StreamBuffer &vertexStream, unsigned int capacity = 65536) : stream(vertexStream) {
+			maxTriangles = capacity;
+			if (maxTriangles > stream.getRegionSize() / bytesPerTriangle)
+				maxTriangles = stream.getRegionSize() / bytesPerTriangle;
+			if (maxTriangles == 0)
+				std::cout << "ERROR::BATCH::REGION_TOO_SMALL for one triangle" << std::endl;
+			currentProgram = 0;
+			drawCalls = 0;
+			triangles = 0;
+			vertices.reserve(maxTriangles * floatsPerTriangle);
+
+			glGenVertexArrays(1, &VAO);
+			glState.bindVertexArray(VAO);
+
+			BatchVertex::setup(stream.getBuffer());
+		}
+
+		void begin() {
+			vertices.clear();
+			currentProgram = 0;
+			drawCalls = 0;
+			triangles = 0;
+		}
+
+		// vertices are 3 floats (x, y, z) per corner, 3 corners per triangle.
+		// Nothing is drawn when the stream region cannot hold a triangle
+		void submit(unsigned int program, const float *triangleVertices, unsigned int count) {
+			if (maxTriangles == 0)
+				return;
+
+			if (program != currentProgram) {
+				flush();
+				currentProgram = program;
+			}
+
+			while (count > 0) {
+				unsigned int used = vertices.size() / floatsPerTriangle;
+				unsigned int space = maxTriangles - used;
+				if (space == 0) {
+					flush();
+					continue;
+				}
+
+				unsigned int n = count < space ? count : space;
+				vertices.insert(vertices.end(), triangleVertices,
+						triangleVertices + n * floatsPerTriangle);
+				triangleVertices += n * floatsPerTriangle;
+				count -= n;
+			}
+		}
+
+		void flush() {
+			if (vertices.empty())
+				return;
+
+			//aligned to a whole vertex so the offset becomes the first vertex
+			int offset = stream.write(vertices.data(), vertices.size() * sizeof(float),
+					3 * sizeof(float));
+			if (offset < 0) {
+				vertices.clear();
+				return;
+			}
+
+			glState.useProgram(currentProgram);
+			glState.bindVertexArray(VAO);
+			glDrawArrays(GL_TRIANGLES, offset / (3 * sizeof(float)), vertices.size() / 3);
+
+			drawCalls++;
+			triangles += vertices.size() / floatsPerTriangle;
+			vertices.clear();
+		}
+
+		void end() {
+			flush();
+		}
+
+		unsigned int getDrawCalls() {
+			return drawCalls;
+		}
+
+		unsigned int getTriangles() {
+			return triangles;
+		}
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#endif
+
+// Instruction sets the SIMD kernels (culling, hit testing) are written for,
+// in increasing order. Kernels are compiled with target attributes and one
+// is picked at runtime, so the program runs on any x86 and elsewhere falls
+// back to scalar code.
+enum SimdLevel {
+	SimdAuto,
+	SimdScalar,
+	SimdSSE2,
+	SimdAVX2
+};
+
+inline SimdLevel detectSimd() {
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+		return SimdAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SimdSSE2;
+#endif
+	return SimdScalar;
+}
+
+// what to run when requested was asked for: the best there is for
+// SimdAuto, never more than the cpu has
+inline SimdLevel chooseSimd(SimdLevel requested) {
+	SimdLevel supported = detectSimd();
+	return requested == SimdAuto || requested > supported ? supported : requested;
+}
+
+inline const char *simdName(SimdLevel level) {
+	const char *names[] = {"auto", "scalar", "sse2", "avx2"};
+	return names[level];
+}
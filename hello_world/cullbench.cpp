@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "culling.cpp"
+
+//./cullbench <shapes> <repeats>
+//culls random boxes against the viewport with every kernel the cpu has,
+//one thread, several thread counts and all threads, and checks they agree
+//with the scalar loop on one thread
+double timeCull(Culler &culler, const CullBounds &bounds, const CullRect &rect,
+		std::vector<unsigned int> &visible, int repeats) {
+	culler.cull(bounds, rect, visible);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < repeats; i++)
+		culler.cull(bounds, rect, visible);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+//every box on screen, so any box a thread count misses shows up as a
+//smaller count than on one thread
+int checkAllVisible(unsigned int count) {
+	CullBounds bounds;
+	bounds.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+		bounds.set(i, -0.5f, -0.5f, 0.5f, 0.5f);
+	CullRect viewport = {-1.0f, -1.0f, 1.0f, 1.0f};
+
+	int mismatches = 0;
+	std::vector<unsigned int> visible;
+	unsigned int threadCounts[] = {1, 3, 9, 16, 0};
+	for (int t = 0; t < 5; t++) {
+		Culler culler(threadCounts[t]);
+		culler.cull(bounds, viewport, visible);
+		if (visible.size() != count) {
+			std::cout << count << " boxes on screen, " << culler.getThreads() << " threads: MISMATCH, "
+				<< visible.size() << " visible" << std::endl;
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+int main(int argc, char** argv) {
+	unsigned int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	int repeats = argc > 2 ? atoi(argv[2]) : 20;
+
+	//boxes spread over twice the viewport, about a quarter of them visible
+	srand(1);
+	CullBounds bounds;
+	bounds.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		float x = rand() / (float)RAND_MAX * 4.0f - 2.0f;
+		float y = rand() / (float)RAND_MAX * 4.0f - 2.0f;
+		bounds.set(i, x, y, x + 0.2f, y + 0.17f);
+	}
+	CullRect viewport = {-1.0f, -1.0f, 1.0f, 1.0f};
+
+	std::vector<unsigned int> expected, visible;
+	Culler reference(1, SimdScalar);
+	reference.cull(bounds, viewport, expected);
+	std::cout << count << " shapes, " << expected.size() << " visible" << std::endl;
+
+	//odd thread counts leave chunks that do not divide the boxes evenly
+	int mismatches = checkAllVisible(count) + checkAllVisible(1440008);
+	const SimdLevel kernels[] = {SimdScalar, SimdSSE2, SimdAVX2};
+	for (int k = 0; k < 3; k++) {
+		unsigned int threadCounts[] = {1, 3, 9, 16, 0};
+		for (int t = 0; t < 5; t++) {
+			Culler culler(threadCounts[t], kernels[k]);
+			if (culler.getKernel() != kernels[k])
+				continue;
+			double ms = timeCull(culler, bounds, viewport, visible, repeats);
+			std::cout << culler.getKernelName() << ", " << culler.getThreads() << " threads: " << ms << " ms";
+			if (visible != expected) {
+				std::cout << " MISMATCH, " << visible.size() << " visible";
+				mismatches++;
+			}
+			std::cout << std::endl;
+		}
+	}
+	return mismatches > 0 ? 1 : 0;
+}
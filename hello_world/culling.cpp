@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <thread>
+#include <vector>
+
+#include "cpufeatures.cpp"
+
+// The visible area in the same space as the bounds. For now the viewport,
+// NDC -1..1; a camera would hand in its frustum's footprint here.
+struct CullRect {
+	float minX;
+	float minY;
+	float maxX;
+	float maxY;
+};
+
+// Axis aligned bounds of many shapes, one array per edge so a kernel tests
+// 4 or 8 shapes with one compare per edge. The arrays are padded to a
+// multiple of 8 with empty boxes (min above max) that are never visible.
+class CullBounds {
+	private:
+		std::vector<float> edges[4];
+		unsigned int count;
+
+	public:
+		CullBounds () {
+			count = 0;
+		}
+
+		void resize(unsigned int size) {
+			count = size;
+			unsigned int padded = (size + 7) / 8 * 8;
+			for (int e = 0; e < 4; e++) {
+				edges[e].resize(padded);
+				for (unsigned int i = size; i < padded; i++)
+					edges[e][i] = e < 2 ? FLT_MAX : -FLT_MAX;
+			}
+		}
+
+		void set(unsigned int index, float minX, float minY, float maxX, float maxY) {
+			edges[0][index] = minX;
+			edges[1][index] = minY;
+			edges[2][index] = maxX;
+			edges[3][index] = maxY;
+		}
+
+		unsigned int size() const {
+			return count;
+		}
+
+		unsigned int paddedSize() const {
+			return edges[0].size();
+		}
+
+		const float *minX() const { return edges[0].data(); }
+		const float *minY() const { return edges[1].data(); }
+		const float *maxX() const { return edges[2].data(); }
+		const float *maxY() const { return edges[3].data(); }
+};
+
+// writes the indices of visible shapes in [begin, end) to out, returns how
+// many. begin and end are multiples of 8; out needs end - begin + 8 slots,
+// the SIMD kernels store whole vectors past the last visible index
+typedef unsigned int (*CullFunction)(const CullBounds &bounds, const CullRect &rect,
+		unsigned int begin, unsigned int end, unsigned int *out);
+
+inline unsigned int cullScalar(const CullBounds &bounds, const CullRect &rect,
+		unsigned int begin, unsigned int end, unsigned int *out) {
+	const float *minX = bounds.minX(), *minY = bounds.minY();
+	const float *maxX = bounds.maxX(), *maxY = bounds.maxY();
+	unsigned int written = 0;
+	for (unsigned int i = begin; i < end; i++) {
+		out[written] = i;
+		written += maxX[i] >= rect.minX && minX[i] <= rect.maxX
+			&& maxY[i] >= rect.minY && minY[i] <= rect.maxY;
+	}
+	return written;
+}
+
+#ifdef SIMD_X86
+// positions of the set bits of every 4 bit mask, the compacted output of a
+// vector is then just base + positions[mask], no shuffle needed
+struct CullTables {
+	alignas(16) int positions4[16][4];
+	unsigned int positions8[256];   //8 positions of 4 bits each
+
+	CullTables () {
+		for (int mask = 0; mask < 256; mask++) {
+			int n = 0;
+			unsigned int packed = 0;
+			for (int bit = 0; bit < 8; bit++) {
+				if (mask & (1 << bit))
+					packed |= bit << (4 * n++);
+			}
+			positions8[mask] = packed;
+			if (mask < 16) {
+				for (int i = 0; i < 4; i++)
+					positions4[mask][i] = (packed >> (4 * i)) & 0xF;
+			}
+		}
+	}
+};
+
+static const CullTables cullTables;
+
+__attribute__((target("sse2")))
+inline unsigned int cullSSE(const CullBounds &bounds, const CullRect &rect,
+		unsigned int begin, unsigned int end, unsigned int *out) {
+	const float *minX = bounds.minX(), *minY = bounds.minY();
+	const float *maxX = bounds.maxX(), *maxY = bounds.maxY();
+	__m128 left = _mm_set1_ps(rect.minX), bottom = _mm_set1_ps(rect.minY);
+	__m128 right = _mm_set1_ps(rect.maxX), top = _mm_set1_ps(rect.maxY);
+	unsigned int *write = out;
+	for (unsigned int i = begin; i < end; i += 4) {
+		__m128 inside = _mm_and_ps(
+				_mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(maxX + i), left), _mm_cmple_ps(_mm_loadu_ps(minX + i), right)),
+				_mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(maxY + i), bottom), _mm_cmple_ps(_mm_loadu_ps(minY + i), top)));
+		int mask = _mm_movemask_ps(inside);
+		__m128i indices = _mm_add_epi32(_mm_set1_epi32(i), _mm_load_si128((const __m128i*)cullTables.positions4[mask]));
+		_mm_storeu_si128((__m128i*)write, indices);
+		write += __builtin_popcount(mask);
+	}
+	return write - out;
+}
+
+__attribute__((target("avx2,popcnt")))
+inline unsigned int cullAVX2(const CullBounds &bounds, const CullRect &rect,
+		unsigned int begin, unsigned int end, unsigned int *out) {
+	const float *minX = bounds.minX(), *minY = bounds.minY();
+	const float *maxX = bounds.maxX(), *maxY = bounds.maxY();
+	__m256 left = _mm256_set1_ps(rect.minX), bottom = _mm256_set1_ps(rect.minY);
+	__m256 right = _mm256_set1_ps(rect.maxX), top = _mm256_set1_ps(rect.maxY);
+	__m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+	__m256i nibble = _mm256_set1_epi32(0xF);
+	unsigned int *write = out;
+	for (unsigned int i = begin; i < end; i += 8) {
+		__m256 inside = _mm256_and_ps(
+				_mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(maxX + i), left, _CMP_GE_OQ),
+					_mm256_cmp_ps(_mm256_loadu_ps(minX + i), right, _CMP_LE_OQ)),
+				_mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(maxY + i), bottom, _CMP_GE_OQ),
+					_mm256_cmp_ps(_mm256_loadu_ps(minY + i), top, _CMP_LE_OQ)));
+		int mask = _mm256_movemask_ps(inside);
+		__m256i positions = _mm256_and_si256(nibble,
+				_mm256_srlv_epi32(_mm256_set1_epi32(cullTables.positions8[mask]), shifts));
+		_mm256_storeu_si256((__m256i*)write, _mm256_add_epi32(_mm256_set1_epi32(i), positions));
+		write += _mm_popcnt_u32(mask);
+	}
+	return write - out;
+}
+#endif
+
+// Finds the shapes whose bounds touch the rect and writes their indices, in
+// order, to a compact list for the renderer. The kernel is picked once from
+// what the cpu supports (AVX2, SSE2, scalar); large inputs are split in
+// chunks across threads, each into its own list, joined afterwards.
+//
+//   Culler culler;
+//   culler.cull(bounds, rect, visible);
+class Culler {
+	private:
+		//below this many shapes per thread starting threads costs more than it saves
+		static const unsigned int minPerThread = 128 * 1024;
+
+		SimdLevel kernel;
+		CullFunction function;
+		unsigned int threads;
+		std::vector<std::vector<unsigned int> > parts;
+		std::vector<unsigned int> counts;
+
+	public:
+		// threadCount 0 uses every hardware thread
+		Culler (unsigned int threadCount = 0, SimdLevel requested = SimdAuto) {
+			threads = threadCount != 0 ? threadCount : std::thread::hardware_concurrency();
+			if (threads == 0)
+				threads = 1;
+
+			kernel = chooseSimd(requested);
+			function = cullScalar;
+#ifdef SIMD_X86
+			if (kernel == SimdSSE2)
+				function = cullSSE;
+			else if (kernel == SimdAVX2)
+				function = cullAVX2;
+#endif
+			parts.resize(threads);
+			counts.resize(threads);
+		}
+
+		void cull(const CullBounds &bounds, const CullRect &rect, std::vector<unsigned int> &visible) {
+			unsigned int padded = bounds.paddedSize();
+			unsigned int used = std::min(threads, std::max(1u, padded / minPerThread));
+			//rounded up, so used chunks always reach the end
+			unsigned int chunk = ((padded + used - 1) / used + 7) / 8 * 8;
+
+			if (used == 1) {
+				visible.resize(padded + 8);
+				visible.resize(function(bounds, rect, 0, padded, visible.data()));
+				return;
+			}
+
+			std::vector<std::thread> workers;
+			for (unsigned int t = 0; t < used; t++) {
+				unsigned int begin = std::min(padded, t * chunk);
+				unsigned int end = std::min(padded, begin + chunk);
+				parts[t].resize(end - begin + 8);
+				if (t == 0)
+					continue;
+				workers.push_back(std::thread([this, &bounds, &rect, t, begin, end]() {
+					counts[t] = function(bounds, rect, begin, end, parts[t].data());
+				}));
+			}
+			counts[0] = function(bounds, rect, 0, std::min(padded, chunk), parts[0].data());
+			for (unsigned int i = 0; i < workers.size(); i++)
+				workers[i].join();
+
+			visible.clear();
+			for (unsigned int t = 0; t < used; t++)
+				visible.insert(visible.end(), parts[t].begin(), parts[t].begin() + counts[t]);
+		}
+
+		SimdLevel getKernel() const {
+			return kernel;
+		}
+
+		const char *getKernelName() const {
+			return simdName(kernel);
+		}
+
+		unsigned int getThreads() const {
+			return threads;
+		}
+};
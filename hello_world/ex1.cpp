@@ -3,24 +3,13 @@
 
 #include <iostream>
 
+#include "shader.cpp"
+#include "vertexformat.cpp"
+#include "meshoptimizer.cpp"
+#include "geometryarena.cpp"
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
-const char *vertexShaderSource = 
-	"#version 330 core\n"
-    	"layout (location = 0) in vec3 aPos;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    	"}\0";
-
-
-const char *fragmentShaderSource = 
-	"#version 330 core\n"
-    	"out vec4 FragColor;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   FragColor = vec4(1.0f, 0.8f, 0.6f, 1.0f);\n"
-    	"}\0";
 
 int main() {
 
@@ -48,43 +37,12 @@ int main() {
 	    return -1;
 	}
 
-	//vertex shader 
-	unsigned int vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	int  success;
-	char infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-
-	if(!success){
-	    glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	//fragment shader
-	unsigned int fragmentShader;
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if(!success){
-	    glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
 	//Shader Program
-	unsigned int shaderProgram;
-	shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	//delete shader objects (no need for them anymore)
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	ProgramShader shader;
+	shader.loadFiles("shaders/shape.vs", "shaders/shape.fs");
+	shader.createShaders();
+	shader.createShaderProgram();
+	unsigned int shaderProgram = shader.getProgram();
 
 	//vertices of triangle
 	float vertices[] = {
@@ -97,20 +55,14 @@ int main() {
 	     1.0f, -0.5f, 0.0f
 	};
 
-	//vertex array object
-	unsigned int VAO;
-	glGenVertexArrays(1, &VAO); 
-	glBindVertexArray(VAO);
-
-	//buffer object where data is stored in gpu
-	unsigned int VBO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	//the shared corner is welded, both triangles are drawn from 5 vertices
+	OptimizedMesh mesh = MeshOptimizer::build(vertices, 6, VertexFormat<Float3>::stride);
+	MeshOptimizer::print("ex1", mesh.report);
 
-	//link input with vertex shader
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	//meshes share the buffers and the VAO of one arena
+	GeometryArena<VertexFormat<Float3> > arena(4096, 16 * 1024);
+	int triangles = arena.add(mesh.vertices.data(), mesh.vertexCount,
+			mesh.indices.data(), mesh.indexCount, mesh.indexType);
 
 	//render loop ---------------------------------------------------------
 	while (!glfwWindowShouldClose(window)) {
@@ -122,9 +74,9 @@ int main() {
 		glClearColor(0.5f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 		
-		glUseProgram(shaderProgram);
-		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		glState.useProgram(shaderProgram);
+		arena.bind();
+		arena.draw(triangles);
 
 		// swap buffers and poll IO events
 		glfwSwapBuffers(window);
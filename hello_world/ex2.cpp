@@ -3,24 +3,11 @@
 
 #include <iostream>
 
+#include "shader.cpp"
+#include "geometryarena.cpp"
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
-const char *vertexShaderSource = 
-	"#version 330 core\n"
-    	"layout (location = 0) in vec3 aPos;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    	"}\0";
-
-
-const char *fragmentShaderSource = 
-	"#version 330 core\n"
-    	"out vec4 FragColor;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   FragColor = vec4(1.0f, 0.8f, 0.6f, 1.0f);\n"
-    	"}\0";
 
 int main() {
 
@@ -48,43 +35,12 @@ int main() {
 	    return -1;
 	}
 
-	//vertex shader 
-	unsigned int vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	int  success;
-	char infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-
-	if(!success){
-	    glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	//fragment shader
-	unsigned int fragmentShader;
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if(!success){
-	    glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
 	//Shader Program
-	unsigned int shaderProgram;
-	shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	//delete shader objects (no need for them anymore)
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	ProgramShader shader;
+	shader.loadFiles("shaders/shape.vs", "shaders/shape.fs");
+	shader.createShaders();
+	shader.createShaderProgram();
+	unsigned int shaderProgram = shader.getProgram();
 
 	//vertices of triangle
 	float vertices1[] = {
@@ -99,27 +55,10 @@ int main() {
 	     1.0f, -0.5f, 0.0f
 	};
 
-	//vertex array object
-	unsigned int VAOs[2];
-	glGenVertexArrays(2, VAOs); 
-	glBindVertexArray(VAOs[0]);
-
-	//buffer object where data is stored in gpu
-	unsigned int VBOs[2];
-	glGenBuffers(2, VBOs);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices1), vertices1, GL_STATIC_DRAW);
-
-	//link input with vertex shader
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glBindVertexArray(VAOs[1]);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices2), vertices2, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	//both triangles are static meshes of one arena, drawn by one multi-draw
+	GeometryArena<VertexFormat<Float3> > arena(4096, 0);
+	arena.add(vertices1, 3);
+	arena.add(vertices2, 3);
 
 	//render loop ---------------------------------------------------------
 	while (!glfwWindowShouldClose(window)) {
@@ -131,12 +70,9 @@ int main() {
 		glClearColor(0.5f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 		
-		glUseProgram(shaderProgram);
-		glBindVertexArray(VAOs[0]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-
-		glBindVertexArray(VAOs[1]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glState.useProgram(shaderProgram);
+		arena.bind();
+		arena.drawAll();
 
 		// swap buffers and poll IO events
 		glfwSwapBuffers(window);
@@ -3,32 +3,12 @@
 
 #include <iostream>
 
+#include "renderqueue.cpp"
+#include "shaderwatcher.cpp"
+#include "vertexformat.cpp"
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
-const char *vertexShaderSource = 
-	"#version 330 core\n"
-    	"layout (location = 0) in vec3 aPos;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    	"}\0";
-
-
-const char *fragmentShaderSource1 = 
-	"#version 330 core\n"
-    	"out vec4 FragColor;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   FragColor = vec4(1.0f, 0.8f, 0.6f, 1.0f);\n"
-    	"}\0";
-
-const char *fragmentShaderSource2 = 
-	"#version 330 core\n"
-    	"out vec4 FragColor;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   FragColor = vec4(0.1f, 1.0f, 0.4f, 1.0f);\n"
-    	"}\0";
 
 int main() {
 
@@ -56,112 +36,111 @@ int main() {
 	    return -1;
 	}
 
-	//vertex shader 
-	unsigned int vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	int  success;
-	char infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-
-	if(!success){
-	    glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	//fragment shader
-	unsigned int fragmentShader1, fragmentShader2;
-	fragmentShader1 = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader1, 1, &fragmentShaderSource1, NULL);
-	glCompileShader(fragmentShader1);
-
-	fragmentShader2 = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader2, 1, &fragmentShaderSource2, NULL);
-	glCompileShader(fragmentShader2);
-
-
-	glGetShaderiv(fragmentShader1, GL_COMPILE_STATUS, &success);
-	if(!success){
-	    glGetShaderInfoLog(fragmentShader1, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	//Shader Program
-	unsigned int shaderProgram1, shaderProgram2;
-	shaderProgram1 = glCreateProgram();
-	glAttachShader(shaderProgram1, vertexShader);
-	glAttachShader(shaderProgram1, fragmentShader1);
-	glLinkProgram(shaderProgram1);
-
-	shaderProgram2 = glCreateProgram();
-	glAttachShader(shaderProgram2, vertexShader);
-	glAttachShader(shaderProgram2, fragmentShader2);
-	glLinkProgram(shaderProgram2);
-
-	//delete shader objects (no need for them anymore)
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader1);
-
-	//vertices of triangle
-	float vertices1[] = {
-	    -1.0f, -0.5f, 0.0f, 
-	    -0.5f,  0.5f, 0.0f,
-	     0.0f, -0.5f, 0.0f,
-	};
-
-	float vertices2[] = {
-	     0.0f, -0.5f, 0.0f,
-	     0.5f,  0.5f, 0.0f,
-	     1.0f, -0.5f, 0.0f
+	//materials: both share one program, only uColor differs
+	ShaderLibrary shaders;
+	MaterialLibrary materials(shaders);
+	std::vector<std::string> blocks;
+	blocks.push_back("FRAME_DATA");
+	blocks.push_back("OBJECT_DATA");
+	Material *material1 = materials.create("shaders/shape.vs", "shaders/shape.fs",
+			1.0f, 0.8f, 0.6f, 1.0f, blocks);
+	Material *material2 = materials.create("shaders/shape.vs", "shaders/shape.fs",
+			0.1f, 1.0f, 0.4f, 1.0f, blocks);
+
+	//edits to the shader files are picked up while running
+	ShaderWatcher watcher;
+	for (unsigned int i = 0; i < materials.programCount(); i++)
+		watcher.watch(materials.getShader(i));
+
+	//vertices of both triangles, drawn as ranges of one buffer. Positions
+	//are int16 quantized: 4 bytes a vertex instead of 12, z comes out 0
+	typedef VertexFormat<Short2Norm> QuantizedVertex;
+	short vertices[] = {
+	    snorm16(-1.0f), snorm16(-0.5f),
+	    snorm16(-0.5f), snorm16( 0.5f),
+	    snorm16( 0.0f), snorm16(-0.5f),
+
+	    snorm16( 0.0f), snorm16(-0.5f),
+	    snorm16( 0.5f), snorm16( 0.5f),
+	    snorm16( 1.0f), snorm16(-0.5f)
 	};
+	static_assert(sizeof(vertices) == 6 * QuantizedVertex::stride, "one quantized vertex per 2 shorts");
 
 	//vertex array object
-	unsigned int VAOs[2];
-	glGenVertexArrays(2, VAOs); 
-	glBindVertexArray(VAOs[0]);
+	unsigned int VAO;
+	glGenVertexArrays(1, &VAO); 
+	glState.bindVertexArray(VAO);
 
 	//buffer object where data is stored in gpu
-	unsigned int VBOs[2];
-	glGenBuffers(2, VBOs);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices1), vertices1, GL_STATIC_DRAW);
+	unsigned int VBO;
+	glGenBuffers(1, &VBO);
+	glState.bindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
 	//link input with vertex shader
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	QuantizedVertex::setup(VBO);
 
-	glBindVertexArray(VAOs[1]);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices2), vertices2, GL_STATIC_DRAW);
+	//draws are submitted in scene order and sorted by state before drawing
+	RenderQueue queue;
+	DrawPacket triangle1 = {0, material1->getProgram(), VAO, GL_TRIANGLES, 0, 3, 0, 0, material1, -1};
+	DrawPacket triangle2 = {0, material2->getProgram(), VAO, GL_TRIANGLES, 3, 3, 0, 0, material2, -1};
+	triangle1.key = makeDrawKey(0, triangle1.program, material1->id, VAO, 0.0f);
+	triangle2.key = makeDrawKey(0, triangle2.program, material2->id, VAO, 0.0f);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	//frame constants and one block per object, in a ring of uniform buffers
+	UniformRing uniforms(64 * 1024);
+	Std140Writer frameBlock;
+	Std140Writer objectBlock;
+	float lastTime = glfwGetTime();
+
+	unsigned int frames = 0;
+	unsigned int maxUniformUploads = 0;
 
 	//render loop ---------------------------------------------------------
 	while (!glfwWindowShouldClose(window)) {
 
 		//input 
 		processInput(window);
+		watcher.poll();
 
 		//render
-		glClearColor(0.5f, 0.3f, 0.3f, 1.0f);
+		glState.clearColor(0.5f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 		
-		glUseProgram(shaderProgram1);
-		glBindVertexArray(VAOs[0]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-
-		glUseProgram(shaderProgram2);
-		glBindVertexArray(VAOs[1]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
+		float now = glfwGetTime();
+		uniforms.beginFrame();
+		FrameData::at(now, now - lastTime, frames).write(frameBlock);
+		uniforms.setFrame(frameBlock);
+		lastTime = now;
+
+		float offset[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		objectBlock.clear();
+		objectBlock.writeVec4(offset);
+		triangle1.objectBlock = uniforms.pushObject(objectBlock);
+		triangle2.objectBlock = uniforms.pushObject(objectBlock);
+		uniforms.upload();
+
+		queue.submit(triangle1);
+		queue.submit(triangle2);
+		queue.execute(&uniforms);
+		uniforms.endFrame();
+		StateCounters frame = glState.endFrame();
+		if (frame.uniformsUploaded > maxUniformUploads)
+			maxUniformUploads = frame.uniformsUploaded;
+		frames++;
 
 		// swap buffers and poll IO events
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
+	StateCounters counters = glState.getTotalCounters();
+	std::cout << "state calls issued: " << counters.issued << ", elided: "
+		<< counters.elided << std::endl;
+	std::cout << "uniform uploads per frame: " << (frames ? (double)counters.uniformsUploaded / frames : 0.0)
+		<< " (max " << maxUniformUploads << "), skipped as unchanged: "
+		<< counters.uniformsSkipped << std::endl;
+
 	glfwTerminate();
 	return 0;
 }
@@ -176,5 +155,5 @@ void processInput(GLFWwindow *window)
 //viewport change when window size is changed
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    glState.viewport(0, 0, width, height);
 }
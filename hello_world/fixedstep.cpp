@@ -0,0 +1,88 @@
+#pragma once
+
+// Runs game logic in ticks of a fixed length however fast frames come.
+// Frame time is added to an accumulator and every whole tick in it is run;
+// what is left over says how far rendering is between the last two ticks,
+// getAlpha(), for blending positions. A frame longer than maxTicks ticks
+// (a hitch, a breakpoint, ticks slower than real time) only counts as
+// maxTicks, the rest is dropped, so slow ticks cannot pile up more ticks
+// every frame until the game stalls.
+//
+//   int ticks = timestep.advance(frameSeconds);
+//   for (int i = 0; i < ticks; i++) tick(timestep.getTick());
+//   render(timestep.getAlpha());
+class FixedTimestep {
+	private:
+		double tick;
+		int maxTicks;
+		double accumulator;
+		unsigned long long ticks;
+		unsigned int clampedFrames;
+		double droppedSeconds;
+		double tickSeconds;
+		unsigned long long timedTicks;
+
+	public:
+		FixedTimestep (double tickLength = 1.0 / 60.0, int maxTicksPerFrame = 8) {
+			tick = tickLength;
+			maxTicks = maxTicksPerFrame;
+			accumulator = 0.0;
+			ticks = 0;
+			clampedFrames = 0;
+			droppedSeconds = 0.0;
+			tickSeconds = 0.0;
+			timedTicks = 0;
+		}
+
+		// adds a frame's time, returns how many ticks to run now
+		int advance(double frameSeconds) {
+			if (frameSeconds < 0.0)
+				frameSeconds = 0.0;
+			double limit = maxTicks * tick;
+			if (frameSeconds > limit) {
+				droppedSeconds += frameSeconds - limit;
+				clampedFrames++;
+				frameSeconds = limit;
+			}
+
+			accumulator += frameSeconds;
+			int count = (int)(accumulator / tick);
+			if (count > maxTicks)
+				count = maxTicks;
+			accumulator -= count * tick;
+			ticks += count;
+			return count;
+		}
+
+		// 0 at the last tick, towards 1 at the next
+		float getAlpha() {
+			float alpha = (float)(accumulator / tick);
+			return alpha > 1.0f ? 1.0f : alpha;
+		}
+
+		double getTick() {
+			return tick;
+		}
+
+		unsigned long long getTicks() {
+			return ticks;
+		}
+
+		unsigned int getClampedFrames() {
+			return clampedFrames;
+		}
+
+		double getDroppedSeconds() {
+			return droppedSeconds;
+		}
+
+		// what running count ticks took, for getAverageTickMs()
+		void addTickTime(double seconds, int count) {
+			tickSeconds += seconds;
+			timedTicks += count;
+		}
+
+		double getAverageTickMs() {
+			return timedTicks > 0 ? tickSeconds * 1000.0 / timedTicks : 0.0;
+		}
+};
@@ -4,44 +4,85 @@
 #include <iostream>
 #include <random>
 #include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+
+#include "shader.cpp"
+#include "shaderlibrary.cpp"
+#include "shadercompiler.cpp"
+#include "shaderwatcher.cpp"
+#include "instancing.cpp"
+#include "uniformbuffer.cpp"
+#include "procedural.cpp"
+#include "simulation.cpp"
+#include "culling.cpp"
+#include "picking.cpp"
+#include "idpicking.cpp"
+#include "random.cpp"
+#include "inputrecord.cpp"
+#include "fixedstep.cpp"
+#include "batch.cpp"
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+void processInput(GLFWwindow *window, InputState &input);
 float randomFloat();
-void changeTrianglePosition(float vertices[]);
+void changeTrianglePosition(Instance &triangle);
+void placeTriangle(Instance &triangle, float x, float y);
 float square(float a);
+void triangleVertices(const Instance &triangle, float vertices[]);
 void print_vertice(float* vertices);
-bool check_valid(GLFWwindow* window, float vertices[]); 
-
-const char *vertexShaderSource = 
-	"#version 330 core\n"
-    	"layout (location = 0) in vec3 aPos;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    	"}\0";
-
-
-const char *fragmentShaderSource = 
-	"#version 330 core\n"
-    	"out vec4 FragColor;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   FragColor = vec4(1.0f, 0.8f, 0.6f, 1.0f);\n"
-    	"}\0";
+void drawBatched(BatchRenderer &batch, unsigned int program, InstancedRenderer &triangles);
+ShapeRecord shapeFromInstance(const Instance &triangle, int sides);
+int shapeSides(int index);
+void setBounds(CullBounds &bounds, int index, const Instance &triangle);
+void setPickable(PickGrid &picker, int index, const Instance &triangle);
 
 float triangle_length = 0.2f;
-
-
-bool button = false;
-
-int main() {
+//height of the equilateral triangle, sqrt(length^2 - (length/2)^2)
+float triangle_height = std::sqrt(square(triangle_length) - square(triangle_length/2));
+
+int main(int argc, char *argv[]) {
+
+	//./game [count] [mode] [picking] [seed] with, anywhere:
+	//  --record <file>  writes seed, arguments and every frame's input
+	//  --replay <file>  plays such a file back frame for frame
+	//  --hidden         no visible window while replaying. The window is only
+	//                   hidden: replays still need a display and an OpenGL 3.3
+	//                   driver, they do not run headless
+	std::vector<std::string> args;
+	std::string recordFile, replayFile;
+	bool hidden = false;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--record" && i + 1 < argc)
+			recordFile = argv[++i];
+		else if (arg == "--replay" && i + 1 < argc)
+			replayFile = argv[++i];
+		else if (arg == "--hidden")
+			hidden = true;
+		else
+			args.push_back(arg);
+	}
+	InputPlayer player;
+	bool replaying = !replayFile.empty();
+	if (replaying) {
+		if (!player.open(replayFile)) {
+			std::cout << "Failed to read input file " << replayFile << std::endl;
+			return -1;
+		}
+		args = player.getArguments();
+	}
+	//recording and replaying trade latency for frames that repeat exactly
+	bool deterministic = replaying || !recordFile.empty();
 
 	// Initialization -----------------------------------------------------
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (replaying && hidden)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
 	//Window creation -----------------------------------------------------
 	GLFWwindow* window = glfwCreateWindow(800, 800, "Hello World!", NULL, NULL);
@@ -61,193 +102,417 @@ int main() {
 	    return -1;
 	}
 
-	//vertex shader 
-	unsigned int vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	int  success;
-	char infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-
-	if(!success){
-	    glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+	//Shader Program, built in the background while the loop already runs
+	ShaderCompiler compiler(window);
+	ShaderLibrary shaders(&compiler);
+	//./game <count> procedural : corners made in the vertex shader
+	//./game <count> gpu        : shapes move by transform feedback
+	//./game <count> batched    : corners built on the cpu, drawn by BatchRenderer
+	//./game <count> <mode> idbuffer : clicks are answered by the gpu
+	std::string mode = args.size() > 1 ? args[1] : "instanced";
+	bool procedural = mode == "procedural";
+	bool gpuSimulation = mode == "gpu";
+	bool batched = mode == "batched";
+	//batched vertices carry no shape index, those clicks stay on the cpu
+	bool idPicking = args.size() > 2 && args[2] == "idbuffer" && !batched;
+
+	//every random number in the game comes from this seed; pass the one
+	//printed here to see the same shapes again: ./game <count> <mode> <picking> <seed>
+	std::random_device device;
+	unsigned long long seed = args.size() > 3 ? std::strtoull(args[3].c_str(), NULL, 10)
+		: (unsigned long long)device() << 32 | device();
+	if (replaying)
+		seed = player.getSeed();
+	seedRandom(seed);
+	std::cout << "seed: " << seed << std::endl;
+
+	InputRecorder recorder;
+	if (!recordFile.empty()) {
+		std::vector<std::string> scene(args.begin(), args.begin() + std::min<size_t>(args.size(), 3));
+		if (!recorder.open(recordFile, seed, scene))
+			std::cout << "Failed to create input file " << recordFile << std::endl;
+	}
+	std::vector<std::string> defines;
+	if (procedural)
+		defines.push_back("PULLED");
+	else if (!batched)
+		defines.push_back("INSTANCED");
+	defines.push_back("FRAME_DATA");
+	if (gpuSimulation)
+		defines.push_back("INTERPOLATED");
+	ProgramShader &shader = *shaders.get("shaders/shape.vs", "shaders/shape.fs", defines);
+	ProgramShader *pickShader = NULL;
+	if (idPicking) {
+		std::vector<std::string> pickDefines = defines;
+		pickDefines.push_back("PICK_ID");
+		pickShader = shaders.get("shaders/shape.vs", "shaders/shape.fs", pickDefines);
 	}
 
-	//fragment shader
-	unsigned int fragmentShader;
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
+	//edits to the shader files are relinked and swapped in while running
+	ShaderWatcher watcher;
+	watcher.watch(&shader);
+	if (pickShader != NULL)
+		watcher.watch(pickShader);
+	bool shaderReported = false;
+
+	//triangles are instances of one unit triangle: offset, scale, color
+	int extraCount = args.size() > 0 ? std::atoi(args[0].c_str()) : 0;
+	InstancedRenderer triangles(2 + extraCount);
+
+	Instance triangle1 = {{-1.0f, -0.5f}, {1.0f, 1.0f}, {255, 204, 153, 255}};
+	Instance triangle2 = {{ 0.0f, -0.5f}, {1.0f, 1.0f}, {255, 204, 153, 255}};
+	triangles.add(triangle1);
+	triangles.add(triangle2);
+
+	//extra triangles to stress the renderer: ./game <count>
+	std::vector<float> spawn(2 * extraCount);
+	randomFill(spawn.data(), spawn.size(), -1.0f, 1.0f);
+	for (int i = 0; i < extraCount; i++) {
+		Instance extra = triangle1;
+		placeTriangle(extra, spawn[2 * i], spawn[2 * i + 1]);
+		triangles.add(extra);
+	}
 
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if(!success){
-	    glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+	//procedural mode uploads one 16 byte record per shape and nothing per
+	//vertex; the extras cycle through triangles, quads, pentagons, hexagons
+	ShapeRenderer shapes(procedural ? triangles.size() : 0);
+	for (int i = 0; procedural && i < triangles.size(); i++)
+		shapes.add(shapeFromInstance(triangles.get(i), shapeSides(i)));
+
+	//gpu mode: the extras drift and bounce, the two player triangles stand
+	//still so their cpu copy stays right for the click test
+	GpuSimulation *simulation = NULL;
+	const float walls[4] = {-1.0f, -1.0f, 1.0f - triangle_length, 1.0f - triangle_height};
+	if (gpuSimulation) {
+		std::vector<ShapeState> states(triangles.size());
+		for (int i = 0; i < triangles.size(); i++) {
+			states[i].position[0] = triangles.get(i).offset[0];
+			states[i].position[1] = triangles.get(i).offset[1];
+			states[i].velocity[0] = i < 2 ? 0.0f : randomFloat() * 0.3f;
+			states[i].velocity[1] = i < 2 ? 0.0f : randomFloat() * 0.3f;
+		}
+		simulation = new GpuSimulation(states);
 	}
 
-	//Shader Program
-	unsigned int shaderProgram;
-	shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	//delete shader objects (no need for them anymore)
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	//vertices of triangle
-	float vertices1[] = {
-	    -1.0f, -0.5f, 0.0f, 
-	    -0.5f,  0.5f, 0.0f,
-	     0.0f, -0.5f, 0.0f,
-	};
-	
-	float vertices2[] = {
-	     0.0f, -0.5f, 0.0f,
-	     0.5f,  0.5f, 0.0f,
-	     1.0f, -0.5f, 0.0f
-	};
-
-	//vertex array object
-	unsigned int VAOs[2];
-	glGenVertexArrays(2, VAOs); 
-	glBindVertexArray(VAOs[0]);
-
-	//buffer object where data is stored in gpu
-	unsigned int VBOs[2];
-	glGenBuffers(2, VBOs);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices1), vertices1, GL_STATIC_DRAW);
-
-	//link input with vertex shader
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	glBindVertexArray(VAOs[1]);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices2), vertices2, GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	//batched mode rebuilds every triangle's corners each frame and draws
+	//them with as few calls as the stream region allows, the baseline the
+	//instanced modes are measured against
+	StreamBuffer batchStream(GL_ARRAY_BUFFER, batched ? triangles.size() * BatchRenderer::bytesPerTriangle : 0);
+	BatchRenderer *batch = batched ? new BatchRenderer(batchStream, triangles.size()) : NULL;
+
+	//instanced mode draws only what touches the viewport; the culled list
+	//is gathered into a stream region, everything visible uses the
+	//persistent buffer as before
+	bool culling = !procedural && !gpuSimulation && !batched;
+	CullBounds bounds;
+	Culler culler;
+	std::vector<unsigned int> visible;
+	unsigned long long visibleTotal = 0;
+	const CullRect viewport = {-1.0f, -1.0f, 1.0f, 1.0f};
+	StreamBuffer instanceStream(GL_ARRAY_BUFFER, culling ? triangles.size() * sizeof(Instance) + sizeof(Instance) : 0);
+	bounds.resize(culling ? triangles.size() : 0);
+	for (int i = 0; culling && i < triangles.size(); i++)
+		setBounds(bounds, i, triangles.get(i));
+
+	//a click moves the topmost triangle under the cursor. On the cpu, in
+	//gpu mode only the two player triangles have a position to test; the id
+	//buffer sees every shape where it is drawn
+	PickGrid picker;
+	IdPicker *idPicker = idPicking ? new IdPicker() : NULL;
+	int cpuPickable = gpuSimulation ? 2 : triangles.size();
+	int pickable = idPicking ? 0 : cpuPickable;
+	for (int i = 0; i < pickable; i++)
+		setPickable(picker, i, triangles.get(i));
+
+	//per-frame constants shared by every program at one binding point
+	UniformRing uniforms(16 * 1024);
+	Std140Writer frameBlock;
+
+	//a replay must not lose its first clicks to frames that only clear
+	while (deterministic && compiler.poll() > 0)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	//clicks and the simulation tick at a fixed rate, frames blend the last
+	//two ticks
+	FixedTimestep timestep(1.0 / 30.0);
+	std::vector<int> idHits;
+
+	unsigned int frames = 0;
+	InputState input;
+	double startTime = glfwGetTime();
+	float lastTime = 0.0f;
 
 	//render loop ---------------------------------------------------------
 	while (!glfwWindowShouldClose(window)) {
-		//input 
-		processInput(window);
+		//input: live, or the recorded frame with its recorded clock
+		if (replaying) {
+			if (!player.next(frames, input))
+				break;
+		} else {
+			processInput(window, input);
+			input.time = glfwGetTime() - startTime;
+		}
+		recorder.record(frames, input);
+		if (input.quit)
+			glfwSetWindowShouldClose(window, true);
 
 		//render
-		glClearColor(0.5f, 0.3f, 0.3f, 1.0f);
+		glState.clearColor(0.5f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		if (button && check_valid(window, vertices1)) {
-			changeTrianglePosition(vertices1);		
-			glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices1), vertices1, 
-					GL_STATIC_DRAW);
-			print_vertice(vertices1);
-			button = false;
+		//the id buffer answers a request from a frame or two ago, one at a
+		//time; the next tick acts on it
+		bool pickRequested = false;
+		if (idPicker != NULL) {
+			int answer;
+			if (idPicker->poll(answer, deterministic) && answer >= 0)
+				idHits.push_back(answer);
+			pickRequested = input.button && input.cursorValid && !idPicker->isPending();
 		}
-		
-		glUseProgram(shaderProgram);
-		glBindVertexArray(VAOs[0]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
 
-		glBindVertexArray(VAOs[1]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
+		//until the program is ready frames only clear
+		compiler.poll();
+		watcher.poll();
+		if (shader.isReady() && !shaderReported) {
+			std::cout << "shader program: " << (shader.isFromCache() ? "warm (binary cache)" : "cold (compiled)")
+				<< " in " << shader.getBuildMilliseconds() << " ms after " << frames << " frames" << std::endl;
+			shaderReported = true;
+		}
+		float now = input.time;
+		float delta = now - lastTime;
+		lastTime = now;
+
+		//game logic runs in whole ticks however long the frame was: a held
+		//button moves one shape a tick, then the simulation steps
+		int ticks = timestep.advance(delta);
+		double tickStart = glfwGetTime();
+		for (int i = 0; i < ticks; i++) {
+			int hit = -1;
+			if (idPicker != NULL) {
+				if (!idHits.empty()) {
+					hit = idHits.front();
+					idHits.erase(idHits.begin());
+				}
+			} else if (input.button && input.cursorValid) {
+				hit = picker.pick(input.cursorX, input.cursorY);
+			}
+			if (hit >= 0) {
+				//only the edited instance is uploaded on the next draw
+				Instance &triangle = triangles.edit(hit);
+				changeTrianglePosition(triangle);		
+				if (!idPicking)
+					setPickable(picker, hit, triangle);
+				//procedural and batched mode never draw the instances, nothing
+				//would upload them
+				if (procedural)
+					shapes.set(hit, shapeFromInstance(triangle, shapeSides(hit)));
+				if (procedural || batched)
+					triangles.discardEdits();
+				if (culling)
+					setBounds(bounds, hit, triangle);
+				if (simulation != NULL) {
+					ShapeState state = {{triangle.offset[0], triangle.offset[1]}, {0.0f, 0.0f}};
+					simulation->set(hit, state);
+				}
+
+				float vertices[9];
+				triangleVertices(triangle, vertices);
+				print_vertice(vertices);
+			}
+
+			if (simulation != NULL)
+				simulation->step(timestep.getTick(), walls);
+		}
+		timestep.addTickTime(glfwGetTime() - tickStart, ticks);
+
+		uniforms.beginFrame();
+		FrameData::at(now, delta, frames, timestep.getAlpha()).write(frameBlock);
+		uniforms.setFrame(frameBlock);
+		uniforms.upload();
+		if (culling) {
+			instanceStream.beginFrame();
+			culler.cull(bounds, viewport, visible);
+			visibleTotal += visible.size();
+		}
+		if (batch != NULL)
+			batchStream.beginFrame();
+
+		if (shader.isReady() && shader.isLinked()) {
+			if (procedural)
+				shapes.draw(shader);
+			else if (batch != NULL)
+				drawBatched(*batch, shader.getProgram(), triangles);
+			else if (simulation != NULL)
+				triangles.drawFed(shader.getProgram(), simulation->getBuffer(), sizeof(ShapeState),
+						simulation->getPreviousBuffer());
+			else if (culling && visible.size() < (unsigned int)triangles.size())
+				triangles.drawVisible(shader.getProgram(), instanceStream, visible);
+			else
+				triangles.draw(shader.getProgram());
+		}
+		if (pickRequested && pickShader->isReady() && pickShader->isLinked()) {
+			int framebufferWidth, framebufferHeight;
+			glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+			if (idPicker->begin(framebufferWidth, framebufferHeight)) {
+				if (procedural)
+					shapes.draw(*pickShader);
+				else if (simulation != NULL)
+					triangles.drawFed(pickShader->getProgram(), simulation->getBuffer(), sizeof(ShapeState),
+							simulation->getPreviousBuffer());
+				else
+					triangles.draw(pickShader->getProgram());
+				idPicker->end(input.cursorX, input.cursorY);
+			} else if (!idPicker->isComplete()) {
+				//no id target on this driver, clicks go back to the cpu grid
+				std::cout << "id picking unavailable, picking on the cpu" << std::endl;
+				delete idPicker;
+				idPicker = NULL;
+				idPicking = false;
+				for (int i = 0; i < cpuPickable; i++)
+					setPickable(picker, i, triangles.get(i));
+			}
+		}
+		if (culling)
+			instanceStream.endFrame();
+		if (batch != NULL)
+			batchStream.endFrame();
+		uniforms.endFrame();
+		glState.endFrame();
+		frames++;
 
 		// swap buffers and poll IO events
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 	}
 
+	recorder.close(frames);
+	double seconds = glfwGetTime() - startTime;
+	std::cout << frames << " frames in " << seconds << " s, "
+		<< (frames > 0 ? seconds * 1000.0 / frames : 0.0) << " ms a frame" << std::endl;
+
+	std::cout << timestep.getTicks() << " ticks of " << timestep.getTick() * 1000.0 << " ms, "
+		<< timestep.getAverageTickMs() << " ms a tick to run, " << timestep.getClampedFrames()
+		<< " long frames clamped (" << timestep.getDroppedSeconds() << " s dropped)" << std::endl;
+
+	//compare against re-uploading every instance each frame
+	UploadStats stats = procedural ? shapes.getUploadStats() : triangles.getUploadStats();
+	unsigned long long fullUploads = (unsigned long long)frames * triangles.size()
+		* (procedural ? sizeof(ShapeRecord) : sizeof(Instance));
+	std::cout << "uploaded " << stats.bytesUploaded << " bytes in " << stats.uploads
+		<< " calls over " << frames << " frames (full re-upload: " << fullUploads
+		<< " bytes)" << std::endl;
+
+	if (culling && frames > 0)
+		std::cout << "culling (" << culler.getKernelName() << ", up to " << culler.getThreads()
+			<< " threads): " << visibleTotal / frames << " of " << triangles.size()
+			<< " triangles visible per frame" << std::endl;
+
+	if (batch != NULL)
+		std::cout << "batched: " << batch->getTriangles() << " triangles in " << batch->getDrawCalls()
+			<< " draw calls a frame, " << batchStream.getTotalStats().bytesStreamed << " bytes streamed" << std::endl;
+
+	if (idPicker != NULL)
+		std::cout << "id picking: " << idPicker->getAnswered() << " clicks answered after "
+			<< idPicker->getAverageLatency() << " frames on average" << std::endl;
+
+	StateCounters counters = glState.getTotalCounters();
+	std::cout << "state calls issued: " << counters.issued << ", elided: "
+		<< counters.elided << std::endl;
+
+	delete batch;
+	delete idPicker;
+	delete simulation;
+	compiler.shutdown();
 	glfwTerminate();
 	return 0;
 }
 
-// process all input
-void processInput(GLFWwindow *window)
+// live input of this frame, the clock is read by the caller
+void processInput(GLFWwindow *window, InputState &input)
 {
-    if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        glfwSetWindowShouldClose(window, true);
-    if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-            double xPos, yPos;
-	    glfwGetCursorPos(window, &xPos, &yPos);
-	    std::cout << xPos << " ; " << yPos << std::endl;
-	    button = true;
-    }
-    if(glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
-	    button = false;
-    }
+    input.quit = glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS;
+    input.button = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    input.cursorValid = cursorToNdc(window, input.cursorX, input.cursorY);
 }
 
 //viewport change when window size is changed
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    glState.viewport(0, 0, width, height);
 }
 
 float randomFloat() {
-	std::random_device rd;
-	std::mt19937 gen(rd());
-	std::uniform_real_distribution<> dist(-1,1);
-	return dist(gen);
+	return threadRandom().range(-1.0f, 1.0f);
 }
 
-void changeTrianglePosition(float vertices[]) {
+void changeTrianglePosition(Instance &triangle) {
 	float rnd1 = randomFloat();
 	float rnd2 = randomFloat();
-	for (int row = 1; row <= 9; row++) {
-		if (row == 1) {
-			vertices[row-1] = rnd1;
-			vertices[row] = rnd2;
-		} else if (row == 4) {
-			vertices[row-1] = rnd1 + triangle_length; 
-			vertices[row] = rnd2;
-		} else if (row == 7) {
-			vertices[row-1] = rnd1 + (triangle_length/2); 
-
-			float a = square(triangle_length/2);
-			float c = square(triangle_length);
-			vertices[row] = rnd2 + (std::sqrt(c-a)); 
-		}
-	}		
+	placeTriangle(triangle, rnd1, rnd2);
 }
 
-void print_vertice(float vertices[]) {
-	for (int row = 0; row < 9; row++) {
-		std::cout << vertices[row] << " | " ;
+void placeTriangle(Instance &triangle, float x, float y) {
+	triangle.offset[0] = x;
+	triangle.offset[1] = y;
+	triangle.scale[0] = triangle_length;
+	triangle.scale[1] = triangle_height;
+}
+
+//corners of the unit triangle (0,0) (1,0) (0.5,1) placed by the instance
+void triangleVertices(const Instance &triangle, float vertices[]) {
+	float unit[] = {0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 1.0f};
+	for (int i = 0; i < 3; i++) {
+		vertices[i*3] = triangle.offset[0] + unit[i*2] * triangle.scale[0];
+		vertices[i*3 + 1] = triangle.offset[1] + unit[i*2 + 1] * triangle.scale[1];
+		vertices[i*3 + 2] = 0.0f;
 	}
-	std::cout << std::endl;
 }
 
-float square(float a) {
-	return a*a;
+//the unit triangle placed by the instance as a regular polygon: centered on
+//the centroid, radii so that a triangle lands exactly on the instance's corners
+ShapeRecord shapeFromInstance(const Instance &triangle, int sides) {
+	float x = triangle.offset[0] + triangle.scale[0] * 0.5f;
+	float y = triangle.offset[1] + triangle.scale[1] / 3.0f;
+	return makeShape(x, y, triangle.scale[0] / std::sqrt(3.0f), triangle.scale[1] * 2.0f / 3.0f,
+			0.0f, sides, triangle.color);
 }
 
-bool check_valid(GLFWwindow* window, float vertices[]) {
-	double xPos, yPos;
-	glfwGetCursorPos(window, &xPos, &yPos);
-	bool res = false;
-	float t1x = vertices[0];
-	float t1y = vertices[1];
+//the instance's triangle as the picker sees it
+void setPickable(PickGrid &picker, int index, const Instance &triangle) {
+	float vertices[9];
+	triangleVertices(triangle, vertices);
+	picker.set(index, vertices[0], vertices[1], vertices[3], vertices[4], vertices[6], vertices[7]);
+}
 
-	float t2x = vertices[3];
-	float t2y = vertices[4];
+//screen space box around the instance's triangle for the culler
+void setBounds(CullBounds &bounds, int index, const Instance &triangle) {
+	bounds.set(index, triangle.offset[0], triangle.offset[1],
+			triangle.offset[0] + triangle.scale[0], triangle.offset[1] + triangle.scale[1]);
+}
 
-	float t3x = vertices[6];
-	float t3y = vertices[7];
-	
-	float area = (t1x * (t2y-t3y) + t2x * (t3y - t1y) + t3x * (t1y - t2y))/2;
+//the player triangles stay triangles, extras cycle through 3 to 6 sides
+int shapeSides(int index) {
+	return index < 2 ? 3 : 3 + index % 4;
+}
 
-	float area1 = (xPos * (t2y-t3y) + t2x * (t3y - yPos) + t3x * (yPos - t2y))/2;
-	float area2 = (t1x * (yPos-t3y) + xPos * (t3y - t1y) + t3x * (t1y - yPos))/2;
-	float area3 = (t1x * (t2y-yPos) + t2x * (yPos - t1y) + xPos * (t1y - t2y))/2;
+//every triangle's corners through the batch, one object at a time
+void drawBatched(BatchRenderer &batch, unsigned int program, InstancedRenderer &triangles) {
+	float vertices[9];
+	batch.begin();
+	for (int i = 0; i < triangles.size(); i++) {
+		triangleVertices(triangles.get(i), vertices);
+		batch.submit(program, vertices, 1);
+	}
+	batch.end();
+}
 
-	float sum = area1 + area2 + area3;
+void print_vertice(float vertices[]) {
+	for (int row = 0; row < 9; row++) {
+		std::cout << vertices[row] << " | " ;
+	}
+	std::cout << std::endl;
+}
 
-	return sum == area;
+float square(float a) {
+	return a*a;
 }
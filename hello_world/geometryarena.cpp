@@ -0,0 +1,270 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "statecache.cpp"
+#include "vertexformat.cpp"
+#include "offsetallocator.cpp"
+
+struct ArenaStats {
+	unsigned int meshes;
+	unsigned int vertexCapacity;
+	unsigned int verticesFree;
+	unsigned int largestVertexRange;
+	unsigned int indexBytesFree;
+	unsigned int defragmentations;
+	unsigned long long bytesMoved;
+};
+
+// Many static meshes of one vertex format in one vertex buffer and one index
+// buffer behind a single VAO. Meshes are sub-allocated with OffsetAllocator:
+// vertices in whole vertices, so an allocation's offset is directly the base
+// vertex, indices in 4 byte words. Index type may differ per mesh.
+//
+//   GeometryArena<VertexFormat<Float3> > arena(65536, 1 << 20);
+//   int mesh = arena.add(vertices, vertexCount, indices, indexCount, GL_UNSIGNED_SHORT);
+//   arena.bind(); arena.draw(mesh);       //or drawAll(), one multi-draw per index type
+//
+// When an add() does not fit because the free space is split up, the arena
+// compacts itself (defragment) into fresh buffers and tries once more.
+template<typename Format>
+class GeometryArena {
+	private:
+		struct Mesh {
+			Allocation vertices;
+			Allocation indices;
+			unsigned int vertexCount;
+			unsigned int indexCount;
+			GLenum indexType;
+			bool live;
+		};
+
+		unsigned int VAO;
+		unsigned int vertexBuffer;
+		unsigned int indexBuffer;
+		unsigned int vertexCapacity;
+		unsigned int indexWords;
+		OffsetAllocator vertexSpace;
+		OffsetAllocator indexSpace;
+		std::vector<Mesh> meshes;
+		unsigned int defragmentations;
+		unsigned long long bytesMoved;
+
+		//scratch for the multi-draw calls
+		std::vector<GLint> firsts;
+		std::vector<GLsizei> counts;
+		std::vector<const void*> offsets;
+		std::vector<GLint> baseVertices;
+
+		static unsigned int indexSize(GLenum type) {
+			return type == GL_UNSIGNED_INT ? 4 : (type == GL_UNSIGNED_SHORT ? 2 : 1);
+		}
+
+		void createBuffers(unsigned int &vertices, unsigned int &indices) {
+			glGenBuffers(1, &vertices);
+			glState.bindBuffer(GL_COPY_WRITE_BUFFER, vertices);
+			glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * Format::stride, NULL, GL_STATIC_DRAW);
+			glGenBuffers(1, &indices);
+			glState.bindBuffer(GL_COPY_WRITE_BUFFER, indices);
+			glBufferData(GL_COPY_WRITE_BUFFER, indexWords * 4, NULL, GL_STATIC_DRAW);
+		}
+
+		void attachBuffers() {
+			glState.bindVertexArray(VAO);
+			Format::setup(vertexBuffer);
+			glState.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		}
+
+		static unsigned int indexWordsOf(const Mesh &mesh) {
+			return (mesh.indexCount * indexSize(mesh.indexType) + 3) / 4;
+		}
+
+		bool allocate(Mesh &mesh) {
+			mesh.vertices = vertexSpace.allocate(mesh.vertexCount);
+			mesh.indices.node = -1;
+			if (mesh.vertices.node < 0)
+				return false;
+			if (mesh.indexCount == 0)
+				return true;
+
+			mesh.indices = indexSpace.allocate(indexWordsOf(mesh));
+			if (mesh.indices.node >= 0)
+				return true;
+			vertexSpace.free(mesh.vertices);
+			mesh.vertices.node = -1;
+			return false;
+		}
+
+		void copyRange(unsigned int from, unsigned int to, unsigned int readOffset,
+				unsigned int writeOffset, unsigned int bytes) {
+			glState.bindBuffer(GL_COPY_READ_BUFFER, from);
+			glState.bindBuffer(GL_COPY_WRITE_BUFFER, to);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, readOffset, writeOffset, bytes);
+			bytesMoved += bytes;
+		}
+
+		static bool byVertexOffset(const std::pair<unsigned int, int> &a, const std::pair<unsigned int, int> &b) {
+			return a.first < b.first;
+		}
+
+	public:
+		GeometryArena (unsigned int maxVertices, unsigned int indexBytes)
+			: vertexSpace(maxVertices), indexSpace((indexBytes + 3) / 4) {
+			vertexCapacity = maxVertices;
+			indexWords = (indexBytes + 3) / 4;
+			defragmentations = 0;
+			bytesMoved = 0;
+
+			glGenVertexArrays(1, &VAO);
+			createBuffers(vertexBuffer, indexBuffer);
+			attachBuffers();
+		}
+
+		// returns the mesh id, or -1 when it does not fit even compacted.
+		// indices are relative to the mesh's own vertices, NULL draws arrays
+		int add(const void *vertices, unsigned int vertexCount, const void *indices = NULL,
+				unsigned int indexCount = 0, GLenum indexType = GL_UNSIGNED_SHORT) {
+			Mesh mesh;
+			mesh.vertexCount = vertexCount;
+			mesh.indexCount = indices != NULL ? indexCount : 0;
+			mesh.indexType = indexType;
+			mesh.live = true;
+			if (!allocate(mesh)) {
+				//compacting cannot make room that is not there
+				if (vertexCount > vertexSpace.getFreeSpace() || indexWordsOf(mesh) > indexSpace.getFreeSpace())
+					return -1;
+				defragment();
+				if (!allocate(mesh))
+					return -1;
+			}
+
+			glState.bindBuffer(GL_COPY_WRITE_BUFFER, vertexBuffer);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.vertices.offset * Format::stride,
+					vertexCount * Format::stride, vertices);
+			if (mesh.indexCount > 0) {
+				glState.bindBuffer(GL_COPY_WRITE_BUFFER, indexBuffer);
+				glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.indices.offset * 4,
+						mesh.indexCount * indexSize(indexType), indices);
+			}
+
+			//reuse a removed mesh's id
+			for (unsigned int i = 0; i < meshes.size(); i++) {
+				if (!meshes[i].live) {
+					meshes[i] = mesh;
+					return i;
+				}
+			}
+			meshes.push_back(mesh);
+			return meshes.size() - 1;
+		}
+
+		void remove(int id) {
+			if (id < 0 || !meshes[id].live)
+				return;
+			vertexSpace.free(meshes[id].vertices);
+			indexSpace.free(meshes[id].indices);
+			meshes[id].live = false;
+		}
+
+		// moves every live mesh to the front of fresh buffers, in vertex
+		// order, and deletes the old ones. The gpu does the copies.
+		void defragment() {
+			unsigned int newVertices, newIndices;
+			createBuffers(newVertices, newIndices);
+
+			std::vector<std::pair<unsigned int, int> > order;
+			for (unsigned int i = 0; i < meshes.size(); i++) {
+				if (meshes[i].live)
+					order.push_back(std::make_pair(meshes[i].vertices.offset, (int)i));
+			}
+			std::sort(order.begin(), order.end(), byVertexOffset);
+
+			vertexSpace.reset(vertexCapacity);
+			indexSpace.reset(indexWords);
+			for (unsigned int i = 0; i < order.size(); i++) {
+				Mesh &mesh = meshes[order[i].second];
+				Mesh old = mesh;
+				allocate(mesh);
+				copyRange(vertexBuffer, newVertices, old.vertices.offset * Format::stride,
+						mesh.vertices.offset * Format::stride, mesh.vertexCount * Format::stride);
+				if (mesh.indexCount > 0)
+					copyRange(indexBuffer, newIndices, old.indices.offset * 4, mesh.indices.offset * 4,
+							mesh.indexCount * indexSize(mesh.indexType));
+			}
+
+			glDeleteBuffers(1, &vertexBuffer);
+			glDeleteBuffers(1, &indexBuffer);
+			vertexBuffer = newVertices;
+			indexBuffer = newIndices;
+			glState.invalidate();
+			attachBuffers();
+			defragmentations++;
+		}
+
+		void bind() {
+			glState.bindVertexArray(VAO);
+		}
+
+		// after bind() and useProgram
+		void draw(int id, GLenum mode = GL_TRIANGLES) {
+			const Mesh &mesh = meshes[id];
+			if (mesh.indexCount == 0) {
+				glDrawArrays(mode, mesh.vertices.offset, mesh.vertexCount);
+				return;
+			}
+			glDrawElementsBaseVertex(mode, mesh.indexCount, mesh.indexType,
+					(void*)(uintptr_t)(mesh.indices.offset * 4), mesh.vertices.offset);
+		}
+
+		// every live mesh with one call per kind: arrays, then each index type
+		void drawAll(GLenum mode = GL_TRIANGLES) {
+			firsts.clear();
+			counts.clear();
+			for (unsigned int i = 0; i < meshes.size(); i++) {
+				if (meshes[i].live && meshes[i].indexCount == 0) {
+					firsts.push_back(meshes[i].vertices.offset);
+					counts.push_back(meshes[i].vertexCount);
+				}
+			}
+			if (!counts.empty())
+				glMultiDrawArrays(mode, firsts.data(), counts.data(), counts.size());
+
+			const GLenum types[] = {GL_UNSIGNED_SHORT, GL_UNSIGNED_INT, GL_UNSIGNED_BYTE};
+			for (int t = 0; t < 3; t++) {
+				counts.clear();
+				offsets.clear();
+				baseVertices.clear();
+				for (unsigned int i = 0; i < meshes.size(); i++) {
+					const Mesh &mesh = meshes[i];
+					if (!mesh.live || mesh.indexCount == 0 || mesh.indexType != types[t])
+						continue;
+					counts.push_back(mesh.indexCount);
+					offsets.push_back((const void*)(uintptr_t)(mesh.indices.offset * 4));
+					baseVertices.push_back(mesh.vertices.offset);
+				}
+				if (!counts.empty())
+					glMultiDrawElementsBaseVertex(mode, counts.data(), types[t],
+							offsets.data(), counts.size(), baseVertices.data());
+			}
+		}
+
+		unsigned int getVertexArray() {
+			return VAO;
+		}
+
+		ArenaStats getStats() {
+			ArenaStats stats;
+			stats.meshes = vertexSpace.getAllocationCount();
+			stats.vertexCapacity = vertexCapacity;
+			stats.verticesFree = vertexSpace.getFreeSpace();
+			stats.largestVertexRange = vertexSpace.largestFreeRange();
+			stats.indexBytesFree = indexSpace.getFreeSpace() * 4;
+			stats.defragmentations = defragmentations;
+			stats.bytesMoved = bytesMoved;
+			return stats;
+		}
+};
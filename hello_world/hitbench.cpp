@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "hittest.cpp"
+
+//./hitbench <triangles> <points>
+//tests points against random triangles with every kernel the cpu has and
+//with the area sum formula the game's old check_valid used, one triangle
+//at a time; then checks the fill rule on a tiling, where every point must
+//hit exactly one triangle, edges and corners included
+
+struct Corners {
+	float x[3];
+	float y[3];
+};
+
+//the old check_valid: the three sub-triangle areas must add up to the
+//triangle's area exactly, which rounding often breaks for inside points
+bool areaSum(const Corners &t, float xPos, float yPos) {
+	float area = (t.x[0] * (t.y[1]-t.y[2]) + t.x[1] * (t.y[2] - t.y[0]) + t.x[2] * (t.y[0] - t.y[1]))/2;
+	float area1 = (xPos * (t.y[1]-t.y[2]) + t.x[1] * (t.y[2] - yPos) + t.x[2] * (yPos - t.y[1]))/2;
+	float area2 = (t.x[0] * (yPos-t.y[2]) + xPos * (t.y[2] - t.y[0]) + t.x[2] * (t.y[0] - yPos))/2;
+	float area3 = (t.x[0] * (t.y[1]-yPos) + t.x[1] * (yPos - t.y[0]) + xPos * (t.y[0] - t.y[1]))/2;
+	return area1 + area2 + area3 == area;
+}
+
+float randomUnit() {
+	return rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+double elapsedNs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+	unsigned int count = argc > 1 ? atoi(argv[1]) : 4096;
+	unsigned int points = argc > 2 ? atoi(argv[2]) : 1000;
+
+	srand(1);
+	std::vector<Corners> corners(count);
+	TriangleSet triangles;
+	for (unsigned int i = 0; i < count; i++) {
+		float x = randomUnit(), y = randomUnit();
+		Corners t = {{x, x + 0.2f, x + 0.1f}, {y, y, y + 0.17f}};
+		corners[i] = t;
+		triangles.add(t.x[0], t.y[0], t.x[1], t.y[1], t.x[2], t.y[2]);
+	}
+	std::vector<float> xs(points), ys(points);
+	for (unsigned int p = 0; p < points; p++) {
+		xs[p] = randomUnit();
+		ys[p] = randomUnit();
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned int areaHits = 0;
+	for (unsigned int p = 0; p < points; p++) {
+		for (unsigned int i = 0; i < count; i++)
+			areaHits += areaSum(corners[i], xs[p], ys[p]);
+	}
+	double areaNs = elapsedNs(start);
+	std::cout << count << " triangles, " << points << " points" << std::endl;
+	std::cout << "area sum (check_valid): " << areaNs / points << " ns a point, "
+		<< areaNs / points / count << " ns a triangle, " << areaHits << " hits" << std::endl;
+
+	std::vector<unsigned char> expected(points * triangles.maskBytes()), masks(expected.size());
+	HitTester(SimdScalar).test(triangles, xs.data(), ys.data(), points, expected.data());
+	int failures = 0;
+	const SimdLevel kernels[] = {SimdScalar, SimdSSE2, SimdAVX2};
+	for (int k = 0; k < 3; k++) {
+		HitTester tester(kernels[k]);
+		if (tester.getKernel() != kernels[k])
+			continue;
+		start = std::chrono::steady_clock::now();
+		unsigned int hits = tester.test(triangles, xs.data(), ys.data(), points, masks.data());
+		double ns = elapsedNs(start);
+		std::cout << tester.getKernelName() << ": " << ns / points << " ns a point, "
+			<< ns / points / count << " ns a triangle, " << hits << " hits"
+			<< (masks == expected ? "" : " MISMATCH") << std::endl;
+		if (masks != expected)
+			failures++;
+	}
+
+	//a 16x16 grid of squares split in two; points on the lattice and on the
+	//diagonals lie on shared edges and corners
+	TriangleSet tiling;
+	const int cells = 16;
+	for (int row = 0; row < cells; row++) {
+		for (int column = 0; column < cells; column++) {
+			float x0 = column / 8.0f - 1.0f, y0 = row / 8.0f - 1.0f;
+			float x1 = x0 + 0.125f, y1 = y0 + 0.125f;
+			tiling.add(x0, y0, x1, y0, x1, y1);
+			tiling.add(x0, y0, x1, y1, x0, y1);
+		}
+	}
+	HitTester tester;
+	std::vector<unsigned char> mask(tiling.maskBytes());
+	unsigned int wrong = 0, tested = 0;
+	for (int row = 1; row < cells * 4; row++) {
+		for (int column = 1; column < cells * 4; column++) {
+			wrong += tester.test(tiling, column / 32.0f - 1.0f, row / 32.0f - 1.0f, mask.data()) != 1;
+			tested++;
+		}
+	}
+	std::cout << "fill rule: " << wrong << " of " << tested << " points on edges and corners hit other than once" << std::endl;
+	if (wrong > 0)
+		failures++;
+	return failures > 0 ? 1 : 0;
+}
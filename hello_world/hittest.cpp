@@ -0,0 +1,255 @@
+#pragma once
+
+#include <vector>
+
+#include "cpufeatures.cpp"
+
+// The three edge equations of one triangle, E(x, y) = a*x + b*y + c with
+// the corners put counter-clockwise, as TriangleSet and PickGrid use them.
+// Degenerate triangles get edges nothing is inside of.
+struct TriangleEdges {
+	float a[3];
+	float b[3];
+	float c[3];
+	int topLeft[3];   //all bits set on a top or left edge
+
+	static TriangleEdges of(float ax, float ay, float bx, float by, float cx, float cy) {
+		TriangleEdges edges;
+		float area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+		if (area < 0.0f) {
+			float x = bx, y = by;
+			bx = cx; by = cy;
+			cx = x; cy = y;
+		}
+		const float xs[3] = {ax, bx, cx};
+		const float ys[3] = {ay, by, cy};
+		for (int e = 0; e < 3; e++) {
+			float x0 = xs[e], y0 = ys[e];
+			float x1 = xs[(e + 1) % 3], y1 = ys[(e + 1) % 3];
+			if (area == 0.0f) {
+				edges.a[e] = 0.0f;
+				edges.b[e] = 0.0f;
+				edges.c[e] = -1.0f;
+				edges.topLeft[e] = 0;
+				continue;
+			}
+			edges.a[e] = y0 - y1;
+			edges.b[e] = x1 - x0;
+			edges.c[e] = x0 * y1 - y0 * x1;
+			//counter-clockwise, y up: a top edge runs right to left, a left edge runs down
+			edges.topLeft[e] = (y1 == y0 && x1 < x0) || y1 < y0 ? -1 : 0;
+		}
+		return edges;
+	}
+
+	// inside by the top-left rule, the same answer as the HitTester kernels
+	bool contains(float x, float y) const {
+		for (int e = 0; e < 3; e++) {
+			float value = a[e] * x + b[e] * y + c[e];
+			if (!(value > 0.0f || (value == 0.0f && topLeft[e] != 0)))
+				return false;
+		}
+		return true;
+	}
+};
+
+// Triangles as edge equations, one array per coefficient (SoA), for testing
+// points against many triangles at once. Edge i of a counter-clockwise
+// triangle is E(x, y) = a*x + b*y + c, positive inside. Coefficients are
+// computed so two triangles sharing an edge get exactly negated values,
+// and the top-left rule decides who owns points on it: E > 0, or E == 0 on
+// a top or left edge. A point on a shared edge hits exactly one of the two.
+//
+// Arrays are padded to a multiple of 8 with triangles nothing hits.
+class TriangleSet {
+	private:
+		//per edge: a, b, c and the top-left flag (all bits set or 0)
+		std::vector<float> a[3];
+		std::vector<float> b[3];
+		std::vector<float> c[3];
+		std::vector<int> topLeft[3];
+		unsigned int count;
+
+		void pad() {
+			unsigned int padded = (count + 7) / 8 * 8;
+			for (int e = 0; e < 3; e++) {
+				a[e].resize(padded, 0.0f);
+				b[e].resize(padded, 0.0f);
+				c[e].resize(padded, -1.0f);
+				topLeft[e].resize(padded, 0);
+			}
+		}
+
+	public:
+		TriangleSet () {
+			count = 0;
+		}
+
+		// returns the index of the new triangle
+		unsigned int add(float ax, float ay, float bx, float by, float cx, float cy) {
+			count++;
+			pad();
+			set(count - 1, ax, ay, bx, by, cx, cy);
+			return count - 1;
+		}
+
+		void set(unsigned int index, float ax, float ay, float bx, float by, float cx, float cy) {
+			TriangleEdges edges = TriangleEdges::of(ax, ay, bx, by, cx, cy);
+			for (int e = 0; e < 3; e++) {
+				a[e][index] = edges.a[e];
+				b[e][index] = edges.b[e];
+				c[e][index] = edges.c[e];
+				topLeft[e][index] = edges.topLeft[e];
+			}
+		}
+
+		unsigned int size() const {
+			return count;
+		}
+
+		unsigned int paddedSize() const {
+			return a[0].size();
+		}
+
+		// bytes of hit mask per point, one bit per triangle
+		unsigned int maskBytes() const {
+			return paddedSize() / 8;
+		}
+
+		const float *edgeA(int e) const { return a[e].data(); }
+		const float *edgeB(int e) const { return b[e].data(); }
+		const float *edgeC(int e) const { return c[e].data(); }
+		const int *edgeTopLeft(int e) const { return topLeft[e].data(); }
+};
+
+// tests the point against every triangle and writes the hit mask, bit i of
+// byte i / 8 for triangle i, returns the number of hits
+typedef unsigned int (*HitFunction)(const TriangleSet &triangles, float x, float y, unsigned char *mask);
+
+inline unsigned int hitTestScalar(const TriangleSet &triangles, float x, float y, unsigned char *mask) {
+	const float *a[3], *b[3], *c[3];
+	const int *topLeft[3];
+	for (int e = 0; e < 3; e++) {
+		a[e] = triangles.edgeA(e);
+		b[e] = triangles.edgeB(e);
+		c[e] = triangles.edgeC(e);
+		topLeft[e] = triangles.edgeTopLeft(e);
+	}
+
+	unsigned int hits = 0;
+	for (unsigned int group = 0; group < triangles.maskBytes(); group++) {
+		unsigned int bits = 0;
+		for (int lane = 0; lane < 8; lane++) {
+			unsigned int i = group * 8 + lane;
+			unsigned int inside = 1;
+			for (int e = 0; e < 3; e++) {
+				float value = a[e][i] * x + b[e][i] * y + c[e][i];
+				inside &= (value > 0.0f) | ((value == 0.0f) & (topLeft[e][i] != 0));
+			}
+			bits |= inside << lane;
+			hits += inside;
+		}
+		mask[group] = bits;
+	}
+	return hits;
+}
+
+#ifdef SIMD_X86
+__attribute__((target("sse2")))
+inline unsigned int hitTestSSE(const TriangleSet &triangles, float x, float y, unsigned char *mask) {
+	__m128 px = _mm_set1_ps(x), py = _mm_set1_ps(y), zero = _mm_setzero_ps();
+	unsigned int hits = 0;
+	for (unsigned int i = 0; i < triangles.paddedSize(); i += 4) {
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int e = 0; e < 3; e++) {
+			__m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(triangles.edgeA(e) + i), px),
+						_mm_mul_ps(_mm_loadu_ps(triangles.edgeB(e) + i), py)), _mm_loadu_ps(triangles.edgeC(e) + i));
+			__m128 onEdge = _mm_and_ps(_mm_cmpeq_ps(value, zero),
+					_mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(triangles.edgeTopLeft(e) + i))));
+			inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(value, zero), onEdge));
+		}
+		int bits = _mm_movemask_ps(inside);
+		if (i % 8 == 0)
+			mask[i / 8] = bits;
+		else
+			mask[i / 8] |= bits << 4;
+		hits += __builtin_popcount(bits);
+	}
+	return hits;
+}
+
+__attribute__((target("avx2,popcnt")))
+inline unsigned int hitTestAVX2(const TriangleSet &triangles, float x, float y, unsigned char *mask) {
+	__m256 px = _mm256_set1_ps(x), py = _mm256_set1_ps(y), zero = _mm256_setzero_ps();
+	unsigned int hits = 0;
+	for (unsigned int i = 0; i < triangles.paddedSize(); i += 8) {
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int e = 0; e < 3; e++) {
+			//mul then add, no fma: shared edges must round the same both ways
+			__m256 value = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(triangles.edgeA(e) + i), px),
+						_mm256_mul_ps(_mm256_loadu_ps(triangles.edgeB(e) + i), py)), _mm256_loadu_ps(triangles.edgeC(e) + i));
+			__m256 onEdge = _mm256_and_ps(_mm256_cmp_ps(value, zero, _CMP_EQ_OQ),
+					_mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)(triangles.edgeTopLeft(e) + i))));
+			inside = _mm256_and_ps(inside, _mm256_or_ps(_mm256_cmp_ps(value, zero, _CMP_GT_OQ), onEdge));
+		}
+		int bits = _mm256_movemask_ps(inside);
+		mask[i / 8] = bits;
+		hits += _mm_popcnt_u32(bits);
+	}
+	return hits;
+}
+#endif
+
+// Point against TriangleSet hit testing with the best kernel the cpu has.
+//
+//   HitTester tester;
+//   std::vector<unsigned char> mask(triangles.maskBytes());
+//   tester.test(triangles, x, y, mask.data());
+//   int top = HitTester::topmost(mask.data(), triangles.maskBytes());
+class HitTester {
+	private:
+		SimdLevel kernel;
+		HitFunction function;
+
+	public:
+		HitTester (SimdLevel requested = SimdAuto) {
+			kernel = chooseSimd(requested);
+			function = hitTestScalar;
+#ifdef SIMD_X86
+			if (kernel == SimdSSE2)
+				function = hitTestSSE;
+			else if (kernel == SimdAVX2)
+				function = hitTestAVX2;
+#endif
+		}
+
+		unsigned int test(const TriangleSet &triangles, float x, float y, unsigned char *mask) const {
+			return function(triangles, x, y, mask);
+		}
+
+		// count points, masks holds count * maskBytes() bytes, point after point
+		unsigned int test(const TriangleSet &triangles, const float *xs, const float *ys,
+				unsigned int count, unsigned char *masks) const {
+			unsigned int hits = 0;
+			for (unsigned int p = 0; p < count; p++)
+				hits += function(triangles, xs[p], ys[p], masks + p * triangles.maskBytes());
+			return hits;
+		}
+
+		// highest triangle index set in the mask, the one drawn last, or -1
+		static int topmost(const unsigned char *mask, unsigned int bytes) {
+			for (int group = (int)bytes - 1; group >= 0; group--) {
+				if (mask[group] != 0)
+					return group * 8 + 31 - __builtin_clz(mask[group]);
+			}
+			return -1;
+		}
+
+		SimdLevel getKernel() const {
+			return kernel;
+		}
+
+		const char *getKernelName() const {
+			return simdName(kernel);
+		}
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+#include "statecache.cpp"
+
+// Picking by drawing. On a frame with a request the scene is drawn once
+// more into an R32UI target, every shape writing its index + 1 (shape.vs
+// and shape.fs with PICK_ID), and the pixel under the cursor is copied into
+// a pixel buffer object. A fence tells when that copy is done, so the
+// answer is mapped a frame or two later instead of stalling the pipeline on
+// a synchronous glReadPixels. Later draws overwrite earlier ones, so the id
+// is the topmost shape just like on screen.
+//
+//   if (picker.begin(width, height)) {   //framebuffer size
+//       ... draw the scene with the PICK_ID programs ...
+//       picker.end(x, y);                 //NDC
+//   }
+//   int id;
+//   if (picker.poll(id)) ...              //-1 when nothing was hit
+// A driver that cannot render to R32UI leaves the target incomplete; then
+// begin() stays false for good and isComplete() tells the caller to pick
+// some other way.
+class IdPicker {
+	private:
+		static const int maxPending = 4;
+
+		struct Readback {
+			unsigned int pixelBuffer;
+			GLsync fence;
+			unsigned int frame;
+		};
+
+		unsigned int framebuffer;
+		unsigned int texture;
+		int width;
+		int height;
+		Readback readbacks[maxPending];
+		int oldest;
+		int pending;
+		unsigned int frame;
+		unsigned int answered;
+		unsigned int framesWaited;
+		bool complete;
+
+		void resize(int newWidth, int newHeight) {
+			width = newWidth;
+			height = newHeight;
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, width, height, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+		}
+
+	public:
+		IdPicker () {
+			width = 0;
+			height = 0;
+			oldest = 0;
+			pending = 0;
+			frame = 0;
+			answered = 0;
+			framesWaited = 0;
+			complete = true;
+
+			glGenTextures(1, &texture);
+			glGenFramebuffers(1, &framebuffer);
+			for (int i = 0; i < maxPending; i++) {
+				glGenBuffers(1, &readbacks[i].pixelBuffer);
+				glState.bindBuffer(GL_PIXEL_PACK_BUFFER, readbacks[i].pixelBuffer);
+				glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(unsigned int), NULL, GL_STREAM_READ);
+				readbacks[i].fence = 0;
+			}
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		}
+
+		// binds and clears the id target, false when too many requests are
+		// still in flight; then nothing is bound and end() must not be called
+		bool begin(int framebufferWidth, int framebufferHeight) {
+			if (!complete || pending == maxPending || framebufferWidth <= 0 || framebufferHeight <= 0)
+				return false;
+
+			if (framebufferWidth != width || framebufferHeight != height) {
+				resize(framebufferWidth, framebufferHeight);
+				glState.bindFramebuffer(framebuffer);
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+				//reading an incomplete target would only give junk ids
+				GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+				if (status != GL_FRAMEBUFFER_COMPLETE) {
+					std::cout << "ERROR::IDPICKER::FRAMEBUFFER_INCOMPLETE 0x" << std::hex << status
+						<< std::dec << std::endl;
+					complete = false;
+					glState.bindFramebuffer(0);
+					return false;
+				}
+			}
+			glState.bindFramebuffer(framebuffer);
+			const unsigned int none[4] = {0, 0, 0, 0};
+			glClearBufferuiv(GL_COLOR, 0, none);
+			return true;
+		}
+
+		// queues the copy of the pixel under x, y and goes back to the window
+		void end(float x, float y) {
+			int pixelX = (int)((x + 1.0f) * 0.5f * width);
+			int pixelY = (int)((y + 1.0f) * 0.5f * height);
+			pixelX = pixelX < 0 ? 0 : (pixelX >= width ? width - 1 : pixelX);
+			pixelY = pixelY < 0 ? 0 : (pixelY >= height ? height - 1 : pixelY);
+
+			Readback &readback = readbacks[(oldest + pending) % maxPending];
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+			glReadPixels(pixelX, pixelY, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			readback.frame = frame;
+			pending++;
+
+			glState.bindFramebuffer(0);
+		}
+
+		// once per frame: true with the answer of the oldest request when the
+		// gpu is done with it. Only waits for it when asked to, which makes
+		// the answer always arrive the frame after the request
+		bool poll(int &id, bool wait = false) {
+			frame++;
+			if (pending == 0)
+				return false;
+
+			Readback &readback = readbacks[oldest];
+			GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			while (wait && result == GL_TIMEOUT_EXPIRED)
+				result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+				return false;
+			glDeleteSync(readback.fence);
+			readback.fence = 0;
+
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+			unsigned int *value = (unsigned int*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+					sizeof(unsigned int), GL_MAP_READ_BIT);
+			id = -1;
+			if (value != NULL) {
+				id = (int)*value - 1;
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			}
+			glState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+			framesWaited += frame - readback.frame;
+			answered++;
+			oldest = (oldest + 1) % maxPending;
+			pending--;
+			return true;
+		}
+
+		bool isComplete() {
+			return complete;
+		}
+
+		bool isPending() {
+			return pending > 0;
+		}
+
+		unsigned int getAnswered() {
+			return answered;
+		}
+
+		// frames between a request and its answer, on average
+		float getAverageLatency() {
+			return answered > 0 ? (float)framesWaited / answered : 0.0f;
+		}
+};
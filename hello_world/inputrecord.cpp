@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Everything the game reads from the outside world in one frame.
+struct InputState {
+	float time;          //seconds since the loop started
+	bool button;         //left mouse button held
+	bool cursorValid;    //false while minimized
+	float cursorX;       //NDC
+	float cursorY;
+	bool quit;           //escape held
+};
+
+enum InputEventType {
+	InputTime = 0,       //float time, every frame
+	InputButton = 1,     //u8 held
+	InputCursor = 2,     //u8 valid, float x, float y
+	InputQuit = 3,       //u8 held
+	InputEnd = 4         //the recording stops before this frame
+};
+
+// Input file layout, host byte order:
+//   "GINP" u32 version  u64 seed  u32 length  arguments (length bytes, '\n' separated)
+//   events: u32 frame  u8 type  payload as listed in InputEventType
+// Only what changed is written, except the frame time.
+static const char inputMagic[4] = {'G', 'I', 'N', 'P'};
+//2: clicks act once a simulation tick instead of once a frame
+static const unsigned int inputVersion = 2;
+
+// Writes the input of every frame to a file while the game runs.
+//
+//   recorder.open("run.input", seed, arguments);
+//   recorder.record(frame, input);   //each frame
+//   recorder.close(frames);
+class InputRecorder {
+	private:
+		std::ofstream file;
+		InputState last;
+		bool first;
+
+		template <typename T>
+		void put(const T &value) {
+			file.write((const char*)&value, sizeof(T));
+		}
+
+		void event(unsigned int frame, unsigned char type) {
+			put(frame);
+			put(type);
+		}
+
+	public:
+		InputRecorder () {
+			first = true;
+		}
+
+		bool open(const std::string &path, unsigned long long seed, const std::vector<std::string> &arguments) {
+			file.open(path.c_str(), std::ios::binary | std::ios::trunc);
+			if (!file)
+				return false;
+
+			std::string joined;
+			for (unsigned int i = 0; i < arguments.size(); i++)
+				joined += (i > 0 ? "\n" : "") + arguments[i];
+			file.write(inputMagic, 4);
+			put(inputVersion);
+			put(seed);
+			put((unsigned int)joined.size());
+			file.write(joined.data(), joined.size());
+			first = true;
+			return true;
+		}
+
+		bool isOpen() {
+			return file.is_open();
+		}
+
+		void record(unsigned int frame, const InputState &input) {
+			if (!file.is_open())
+				return;
+
+			event(frame, InputTime);
+			put(input.time);
+			if (first || input.button != last.button) {
+				event(frame, InputButton);
+				put((unsigned char)input.button);
+			}
+			if (first || input.cursorValid != last.cursorValid
+					|| input.cursorX != last.cursorX || input.cursorY != last.cursorY) {
+				event(frame, InputCursor);
+				put((unsigned char)input.cursorValid);
+				put(input.cursorX);
+				put(input.cursorY);
+			}
+			if (first || input.quit != last.quit) {
+				event(frame, InputQuit);
+				put((unsigned char)input.quit);
+			}
+			last = input;
+			first = false;
+		}
+
+		// frames is the number of frames recorded
+		void close(unsigned int frames) {
+			if (!file.is_open())
+				return;
+			event(frames, InputEnd);
+			file.close();
+		}
+};
+
+// Plays an input file back frame by frame. The game takes its arguments and
+// seed from the file and its input and clock from next(), so the same frames
+// see the same clicks, times and random numbers as when recorded.
+class InputPlayer {
+	private:
+		std::vector<char> data;
+		unsigned int at;
+		unsigned long long seed;
+		std::vector<std::string> arguments;
+		InputState state;
+		bool ended;
+
+		template <typename T>
+		bool get(T &value) {
+			if (at + sizeof(T) > data.size())
+				return false;
+			memcpy(&value, &data[at], sizeof(T));
+			at += sizeof(T);
+			return true;
+		}
+
+	public:
+		InputPlayer () {
+			at = 0;
+			seed = 0;
+			ended = true;
+			memset(&state, 0, sizeof(state));
+		}
+
+		bool open(const std::string &path) {
+			std::ifstream file(path.c_str(), std::ios::binary);
+			if (!file)
+				return false;
+			data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+			at = 0;
+			unsigned int version, length;
+			if (data.size() < 4 || memcmp(&data[0], inputMagic, 4) != 0)
+				return false;
+			at = 4;
+			if (!get(version) || version != inputVersion || !get(seed) || !get(length)
+					|| at + length > data.size())
+				return false;
+
+			arguments.clear();
+			std::string joined(&data[at], length);
+			at += length;
+			for (size_t start = 0; start < joined.size(); ) {
+				size_t end = joined.find('\n', start);
+				if (end == std::string::npos)
+					end = joined.size();
+				arguments.push_back(joined.substr(start, end - start));
+				start = end + 1;
+			}
+			ended = false;
+			return true;
+		}
+
+		unsigned long long getSeed() {
+			return seed;
+		}
+
+		const std::vector<std::string> &getArguments() {
+			return arguments;
+		}
+
+		// the input of frame, false once the recording is over
+		bool next(unsigned int frame, InputState &input) {
+			bool read = false;
+			while (!ended) {
+				//a file cut short ends after its last complete frame
+				if (at >= data.size()) {
+					ended = true;
+					break;
+				}
+				unsigned int eventFrame;
+				unsigned char type;
+				unsigned int mark = at;
+				if (!get(eventFrame) || !get(type)) {
+					ended = true;
+					break;
+				}
+				if (eventFrame > frame) {
+					at = mark;
+					break;
+				}
+
+				unsigned char flag = 0;
+				bool ok = true;
+				if (type == InputTime) {
+					ok = get(state.time);
+				} else if (type == InputButton) {
+					ok = get(flag);
+					state.button = flag != 0;
+				} else if (type == InputCursor) {
+					ok = get(flag) && get(state.cursorX) && get(state.cursorY);
+					state.cursorValid = flag != 0;
+				} else if (type == InputQuit) {
+					ok = get(flag);
+					state.quit = flag != 0;
+				} else {
+					ended = true;
+				}
+				if (!ok)
+					ended = true;
+				else
+					read = type != InputEnd;
+			}
+			input = state;
+			return !ended || read;
+		}
+};
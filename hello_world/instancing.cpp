@@ -0,0 +1,180 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "statecache.cpp"
+#include "streambuffer.cpp"
+#include "mirroredbuffer.cpp"
+#include "vertexformat.cpp"
+
+// Per-instance data: where the shared unit triangle goes, how big it is and
+// its color. Moving an instance only uploads its 8 byte offset.
+struct Instance {
+	float offset[2];
+	float scale[2];
+	unsigned char color[4];
+};
+
+typedef VertexFormat<Half2> MeshFormat;
+typedef VertexFormat<Float2, Float2, UByte4Norm> InstanceFormat;
+static_assert(InstanceFormat::stride == sizeof(Instance), "InstanceFormat must match Instance");
+static_assert(InstanceFormat::offset(2) == offsetof(Instance, color), "InstanceFormat must match Instance");
+
+// Draws many copies of one unit triangle, corners (0,0) (1,0) (0.5,1), with a
+// single glDrawArraysInstanced. Shader inputs:
+//   location 0: vec2 corner of the unit triangle (half floats)
+//   location 1: vec2 offset      (per instance)
+//   location 2: vec2 scale       (per instance)
+//   location 3: vec4 color       (per instance, normalized bytes)
+//   location 4: vec2 previous offset, drawFed() with a previous buffer only
+class InstancedRenderer {
+	private:
+		unsigned int VAO;
+		unsigned int meshVBO;
+		MirroredBuffer<Instance> instances;
+		unsigned int attribBuffer;
+		unsigned int attribOffset;
+
+		//per instance attributes read from buffer starting at offset
+		void pointInstanceAttributes(unsigned int buffer, unsigned int offset) {
+			if (buffer == attribBuffer && offset == attribOffset)
+				return;
+
+			glState.bindBuffer(GL_ARRAY_BUFFER, buffer);
+			InstanceFormat::point(1, offset);
+			attribBuffer = buffer;
+			attribOffset = offset;
+		}
+
+	public:
+		InstancedRenderer (unsigned int maxInstances) : instances(GL_ARRAY_BUFFER, maxInstances) {
+			//exact in half floats, 4 bytes a vertex
+			unsigned short unitTriangle[] = {
+				halfFromFloat(0.0f), halfFromFloat(0.0f),
+				halfFromFloat(1.0f), halfFromFloat(0.0f),
+				halfFromFloat(0.5f), halfFromFloat(1.0f)
+			};
+
+			glGenVertexArrays(1, &VAO);
+			glState.bindVertexArray(VAO);
+
+			glGenBuffers(1, &meshVBO);
+			glState.bindBuffer(GL_ARRAY_BUFFER, meshVBO);
+			glBufferData(GL_ARRAY_BUFFER, sizeof(unitTriangle), unitTriangle, GL_STATIC_DRAW);
+			MeshFormat::setup(meshVBO);
+
+			attribBuffer = 0;
+			pointInstanceAttributes(instances.getBuffer(), 0);
+			InstanceFormat::enableAll(1, 1);
+		}
+
+		// returns the index of the new instance, or -1 when full
+		int add(const Instance &instance) {
+			return instances.push(instance);
+		}
+
+		void setOffset(int index, float x, float y) {
+			Instance &instance = instances.editPart(index, offsetof(Instance, offset),
+					sizeof(instance.offset));
+			instance.offset[0] = x;
+			instance.offset[1] = y;
+		}
+
+		void set(int index, const Instance &instance) {
+			instances.set(index, instance);
+		}
+
+		// writable instance, uploaded with the next draw
+		Instance &edit(int index) {
+			return instances.edit(index);
+		}
+
+		// forgets edits instead of uploading them, for a renderer only kept
+		// as the cpu copy of shapes that another renderer draws
+		void discardEdits() {
+			instances.discardDirty();
+		}
+
+		const Instance &get(int index) {
+			return instances[index];
+		}
+
+		int size() {
+			return instances.size();
+		}
+
+		const UploadStats &getUploadStats() {
+			return instances.getTotalStats();
+		}
+
+		// uploads the ranges edited since the last draw, then draws
+		void draw(unsigned int program) {
+			if (instances.size() == 0)
+				return;
+
+			instances.flush();
+			instances.endFrame();
+
+			glState.useProgram(program);
+			glState.bindVertexArray(VAO);
+			pointInstanceAttributes(instances.getBuffer(), 0);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 3, instances.size());
+		}
+
+		// offsets come from another buffer, e.g. GpuSimulation's state: the
+		// first two floats of every stride bytes. Scale and color stay ours.
+		// previousBuffer, laid out the same, feeds location 4 for shaders
+		// that blend between two simulation ticks
+		void drawFed(unsigned int program, unsigned int offsetBuffer, unsigned int stride,
+				unsigned int previousBuffer = 0) {
+			if (instances.size() == 0)
+				return;
+
+			instances.flush();
+			instances.endFrame();
+
+			glState.useProgram(program);
+			glState.bindVertexArray(VAO);
+			pointInstanceAttributes(instances.getBuffer(), 0);
+			glState.bindBuffer(GL_ARRAY_BUFFER, offsetBuffer);
+			Float2::point(1, stride, 0);
+			//the next draw has to point location 1 back at the instances
+			attribBuffer = 0;
+			if (previousBuffer != 0) {
+				glState.bindBuffer(GL_ARRAY_BUFFER, previousBuffer);
+				Float2::point(4, stride, 0);
+				VertexFormat<Float2>::enableAll(4, 1);
+			}
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 3, instances.size());
+			if (previousBuffer != 0)
+				glDisableVertexAttribArray(4);
+		}
+
+		// only the listed instances, e.g. what a Culler found visible: they
+		// are gathered from the cpu copy straight into the frame's stream
+		// region. Edits still go to the persistent buffer for draw()
+		void drawVisible(unsigned int program, StreamBuffer &stream, const std::vector<unsigned int> &visible) {
+			if (visible.empty())
+				return;
+
+			instances.flush();
+			instances.endFrame();
+
+			unsigned int offset;
+			Instance *out = (Instance*)stream.map(visible.size() * sizeof(Instance), sizeof(Instance), offset);
+			if (out == NULL)
+				return;
+			for (unsigned int i = 0; i < visible.size(); i++)
+				out[i] = instances[visible[i]];
+			stream.unmap();
+
+			glState.useProgram(program);
+			glState.bindVertexArray(VAO);
+			pointInstanceAttributes(stream.getBuffer(), offset);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 3, visible.size());
+		}
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "shader.cpp"
+#include "shaderlibrary.cpp"
+#include "statecache.cpp"
+
+struct Material;
+
+// A linked program shared by every material built from the same sources.
+// current is the material whose uniforms are loaded in the program right now.
+struct MaterialProgram {
+	ProgramShader *shader;
+	int colorHandle;
+	unsigned int generation;
+	const Material *current;
+
+	MaterialProgram (ProgramShader *program) {
+		shader = program;
+		refresh();
+	}
+
+	// handles and loaded uniforms are lost when the shader was reloaded
+	void refresh() {
+		colorHandle = shader->uniformHandle("uColor");
+		generation = shader->getGeneration();
+		current = NULL;
+	}
+};
+
+// Parameters for one look of a shared program. Switching between materials of
+// the same program only reloads uniforms, never the program.
+struct Material {
+	unsigned int id;
+	MaterialProgram *program;
+	float color[4];
+
+	void setColor(float r, float g, float b, float a) {
+		color[0] = r;
+		color[1] = g;
+		color[2] = b;
+		color[3] = a;
+		if (program->current == this)
+			program->current = NULL;
+	}
+
+	unsigned int getProgram() const {
+		return program->shader->getProgram();
+	}
+
+	void apply() const {
+		if (program->generation != program->shader->getGeneration())
+			program->refresh();
+
+		glState.useProgram(program->shader->getProgram());
+		if (program->current == this)
+			return;
+
+		program->shader->setUniform(program->colorHandle, color);
+		program->current = this;
+	}
+};
+
+// Owns materials. Programs come from the ShaderLibrary as the
+// COLOR_FROM_UNIFORM permutation, which already shares one program between
+// identical sources, even under another file name.
+class MaterialLibrary {
+	private:
+		ShaderLibrary &shaders;
+		std::deque<MaterialProgram> programs;
+		std::deque<Material> materials;
+
+	public:
+		// the library must build synchronously, uColor is looked up right away
+		MaterialLibrary (ShaderLibrary &shaderLibrary) : shaders(shaderLibrary) {
+		}
+
+		MaterialProgram *getProgram(const char *vertexFile, const char *fragmentFile,
+				const std::vector<std::string> &extraDefines = std::vector<std::string>()) {
+			std::vector<std::string> defines(extraDefines);
+			defines.push_back("COLOR_FROM_UNIFORM");
+			ProgramShader *shader = shaders.get(vertexFile, fragmentFile, defines);
+			for (unsigned int i = 0; i < programs.size(); i++) {
+				if (programs[i].shader == shader)
+					return &programs[i];
+			}
+			programs.emplace_back(shader);
+			return &programs.back();
+		}
+
+		// the fragment shader reads its color from "uniform vec4 uColor"
+		Material *create(const char *vertexFile, const char *fragmentFile,
+				float r, float g, float b, float a,
+				const std::vector<std::string> &defines = std::vector<std::string>()) {
+			Material material;
+			material.id = materials.size() + 1;
+			material.program = getProgram(vertexFile, fragmentFile, defines);
+			material.color[0] = r;
+			material.color[1] = g;
+			material.color[2] = b;
+			material.color[3] = a;
+			materials.push_back(material);
+			return &materials.back();
+		}
+
+		ProgramShader *getShader(unsigned int index) {
+			return programs[index].shader;
+		}
+
+		unsigned int programCount() {
+			return programs.size();
+		}
+
+		unsigned int materialCount() {
+			return materials.size();
+		}
+};
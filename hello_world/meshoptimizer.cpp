@@ -0,0 +1,294 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+struct MeshReport {
+	unsigned int inputVertices;
+	unsigned int vertices;      //after welding
+	unsigned int triangles;
+	float acmrBefore;           //vertex shader runs per triangle, welded input order
+	float acmrAfter;
+	unsigned int indexBytes;
+};
+
+// A mesh ready for glBufferData: interleaved vertices and packed 16 or 32
+// bit indices, whichever fits, drawn with
+//   glDrawElements(GL_TRIANGLES, indexCount, indexType, 0)
+struct OptimizedMesh {
+	std::vector<unsigned char> vertices;
+	std::vector<unsigned char> indices;
+	unsigned int stride;
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	GLenum indexType;
+	MeshReport report;
+};
+
+// Offline style mesh processing for static geometry:
+//   weld                bit-identical vertices become one, indices are generated
+//   optimizeVertexCache triangle order for the post-transform cache (Forsyth's
+//                       linear-speed algorithm, 32 entry LRU model)
+//   optimizeVertexFetch vertices in order of first use, so fetches walk forward
+//   acmr                average cache miss ratio on a FIFO of the given size,
+//                       3.0 is no reuse at all, ~0.5-0.7 is good for a grid
+// Vertices are opaque bytes of a given stride, any VertexFormat works.
+class MeshOptimizer {
+	private:
+		static const int cacheSize = 32;
+
+		static unsigned long long hashBytes(const unsigned char *bytes, unsigned int size) {
+			unsigned long long hash = 14695981039346656037ULL;
+			for (unsigned int i = 0; i < size; i++) {
+				hash ^= bytes[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		static float vertexScore(int cachePosition, unsigned int remaining) {
+			if (remaining == 0)
+				return -1.0f;
+
+			float score = 0.0f;
+			if (cachePosition >= 0) {
+				//the last triangle's vertices get a fixed score so the next
+				//triangle does not simply reuse the same edge over and over
+				if (cachePosition < 3)
+					score = 0.75f;
+				else
+					score = powf(1.0f - (cachePosition - 3) / (float)(cacheSize - 3), 1.5f);
+			}
+			//favour vertices with few triangles left, finishing them frees the cache
+			return score + 2.0f * powf((float)remaining, -0.5f);
+		}
+
+	public:
+		// welds count vertices of stride bytes into vertices/indices, returns
+		// how many unique vertices are left
+		static unsigned int weld(const void *soup, unsigned int count, unsigned int stride,
+				std::vector<unsigned char> &vertices, std::vector<unsigned int> &indices) {
+			const unsigned char *input = (const unsigned char*)soup;
+			unsigned int tableSize = 1;
+			while (tableSize < count * 2)
+				tableSize *= 2;
+			std::vector<unsigned int> table(tableSize, 0xFFFFFFFF);
+
+			vertices.clear();
+			indices.resize(count);
+			unsigned int unique = 0;
+			for (unsigned int i = 0; i < count; i++) {
+				const unsigned char *vertex = input + i * stride;
+				unsigned int slot = hashBytes(vertex, stride) & (tableSize - 1);
+				while (table[slot] != 0xFFFFFFFF
+						&& memcmp(&vertices[table[slot] * stride], vertex, stride) != 0)
+					slot = (slot + 1) & (tableSize - 1);
+
+				if (table[slot] == 0xFFFFFFFF) {
+					table[slot] = unique++;
+					vertices.insert(vertices.end(), vertex, vertex + stride);
+				}
+				indices[i] = table[slot];
+			}
+			return unique;
+		}
+
+		static void optimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount) {
+			unsigned int triangleCount = indices.size() / 3;
+			if (triangleCount == 0)
+				return;
+
+			//triangles of every vertex, packed; the first remaining[v] of a
+			//vertex's list are the ones not emitted yet
+			std::vector<unsigned int> remaining(vertexCount, 0);
+			for (unsigned int i = 0; i < indices.size(); i++)
+				remaining[indices[i]]++;
+			std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+			for (unsigned int v = 0; v < vertexCount; v++)
+				firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+			std::vector<unsigned int> adjacency(indices.size());
+			std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+			for (unsigned int i = 0; i < indices.size(); i++)
+				adjacency[filled[indices[i]]++] = i / 3;
+
+			std::vector<int> cachePosition(vertexCount, -1);
+			std::vector<float> score(vertexCount);
+			for (unsigned int v = 0; v < vertexCount; v++)
+				score[v] = vertexScore(-1, remaining[v]);
+
+			std::vector<float> triangleScore(triangleCount);
+			std::vector<bool> emitted(triangleCount, false);
+			for (unsigned int t = 0; t < triangleCount; t++)
+				triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+			std::vector<unsigned int> output;
+			output.reserve(indices.size());
+			std::vector<unsigned int> cache, newCache;
+			int best = -1;
+			unsigned int scanStart = 0;
+
+			while (output.size() < indices.size()) {
+				if (best < 0) {
+					//nothing in the cache connects to what is left: best of the rest
+					float bestScore = -1.0f;
+					for (unsigned int t = scanStart; t < triangleCount; t++) {
+						if (!emitted[t] && triangleScore[t] > bestScore) {
+							bestScore = triangleScore[t];
+							best = t;
+						}
+					}
+					while (scanStart < triangleCount && emitted[scanStart])
+						scanStart++;
+				}
+
+				const unsigned int *corners = &indices[best * 3];
+				output.insert(output.end(), corners, corners + 3);
+				emitted[best] = true;
+
+				newCache.assign(corners, corners + 3);
+				for (int i = 0; i < 3; i++) {
+					unsigned int v = corners[i];
+					unsigned int *list = &adjacency[firstTriangle[v]];
+					for (unsigned int j = 0; j < remaining[v]; j++) {
+						if (list[j] == (unsigned int)best) {
+							list[j] = list[remaining[v] - 1];
+							remaining[v]--;
+							break;
+						}
+					}
+				}
+				for (unsigned int i = 0; i < cache.size(); i++) {
+					if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2])
+						newCache.push_back(cache[i]);
+				}
+
+				//rescore everything that moved in, moved around or fell out
+				best = -1;
+				float bestScore = -1.0f;
+				for (unsigned int i = 0; i < newCache.size(); i++) {
+					unsigned int v = newCache[i];
+					cachePosition[v] = i < (unsigned int)cacheSize ? (int)i : -1;
+					float updated = vertexScore(cachePosition[v], remaining[v]);
+					float delta = updated - score[v];
+					score[v] = updated;
+
+					const unsigned int *list = &adjacency[firstTriangle[v]];
+					for (unsigned int j = 0; j < remaining[v]; j++) {
+						unsigned int t = list[j];
+						triangleScore[t] += delta;
+						if (cachePosition[v] >= 0 && triangleScore[t] > bestScore) {
+							bestScore = triangleScore[t];
+							best = t;
+						}
+					}
+				}
+				if (newCache.size() > (unsigned int)cacheSize)
+					newCache.resize(cacheSize);
+				cache.swap(newCache);
+			}
+			indices.swap(output);
+		}
+
+		// renumbers vertices in order of first use and drops unused ones,
+		// returns the new vertex count
+		static unsigned int optimizeVertexFetch(std::vector<unsigned char> &vertices, unsigned int stride,
+				std::vector<unsigned int> &indices) {
+			unsigned int vertexCount = vertices.size() / stride;
+			std::vector<unsigned int> remap(vertexCount, 0xFFFFFFFF);
+			std::vector<unsigned char> ordered;
+			ordered.reserve(vertices.size());
+
+			unsigned int next = 0;
+			for (unsigned int i = 0; i < indices.size(); i++) {
+				unsigned int v = indices[i];
+				if (remap[v] == 0xFFFFFFFF) {
+					remap[v] = next++;
+					ordered.insert(ordered.end(), &vertices[v * stride], &vertices[v * stride] + stride);
+				}
+				indices[i] = remap[v];
+			}
+			vertices.swap(ordered);
+			return next;
+		}
+
+		static float acmr(const std::vector<unsigned int> &indices, unsigned int vertexCount,
+				unsigned int fifoSize = 16) {
+			if (indices.size() < 3)
+				return 0.0f;
+
+			//a vertex is cached while fewer than fifoSize misses came after it
+			std::vector<unsigned int> insertedAt(vertexCount, 0);
+			unsigned int misses = 0;
+			for (unsigned int i = 0; i < indices.size(); i++) {
+				unsigned int v = indices[i];
+				if (insertedAt[v] == 0 || misses + 1 - insertedAt[v] > fifoSize) {
+					misses++;
+					insertedAt[v] = misses;
+				}
+			}
+			return (float)misses / (indices.size() / 3);
+		}
+
+		static GLenum indexType(unsigned int vertexCount) {
+			return vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		}
+
+		static void packIndices(const std::vector<unsigned int> &indices, GLenum type,
+				std::vector<unsigned char> &out) {
+			if (type == GL_UNSIGNED_INT) {
+				out.resize(indices.size() * 4);
+				memcpy(out.data(), indices.data(), out.size());
+				return;
+			}
+
+			out.resize(indices.size() * 2);
+			for (unsigned int i = 0; i < indices.size(); i++) {
+				unsigned short index = indices[i];
+				memcpy(&out[i * 2], &index, 2);
+			}
+		}
+
+		// the whole pipeline. indices may be NULL for a triangle soup; an
+		// indexed mesh is expanded first so duplicates in it are welded too
+		static OptimizedMesh build(const void *vertices, unsigned int vertexCount, unsigned int stride,
+				const unsigned int *indices = NULL, unsigned int indexCount = 0) {
+			std::vector<unsigned char> soup;
+			const unsigned char *input = (const unsigned char*)vertices;
+			if (indices == NULL) {
+				soup.assign(input, input + vertexCount * stride);
+			} else {
+				for (unsigned int i = 0; i < indexCount; i++)
+					soup.insert(soup.end(), input + indices[i] * stride, input + (indices[i] + 1) * stride);
+			}
+
+			OptimizedMesh mesh;
+			mesh.stride = stride;
+			std::vector<unsigned int> welded;
+			unsigned int unique = weld(soup.data(), soup.size() / stride, stride, mesh.vertices, welded);
+			mesh.report.acmrBefore = acmr(welded, unique);
+			optimizeVertexCache(welded, unique);
+			mesh.vertexCount = optimizeVertexFetch(mesh.vertices, stride, welded);
+			mesh.indexCount = welded.size();
+			mesh.indexType = indexType(mesh.vertexCount);
+			packIndices(welded, mesh.indexType, mesh.indices);
+
+			mesh.report.inputVertices = vertexCount;
+			mesh.report.vertices = mesh.vertexCount;
+			mesh.report.triangles = mesh.indexCount / 3;
+			mesh.report.acmrAfter = acmr(welded, mesh.vertexCount);
+			mesh.report.indexBytes = mesh.indices.size();
+			return mesh;
+		}
+
+		static void print(const char *name, const MeshReport &report) {
+			std::cout << name << ": " << report.inputVertices << " -> " << report.vertices
+				<< " vertices, " << report.triangles << " triangles, ACMR "
+				<< report.acmrBefore << " -> " << report.acmrAfter << ", "
+				<< report.indexBytes << " index bytes" << std::endl;
+		}
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "statecache.cpp"
+
+struct UploadStats {
+	unsigned long long bytesUploaded;
+	unsigned int uploads;        //glBufferSubData calls after coalescing
+	unsigned int rangesMarked;   //edits recorded before coalescing
+};
+
+// CPU copy of a gpu buffer of T. Edits go to the copy and record the touched
+// byte range, flush() merges overlapping or nearby ranges and uploads only
+// those with glBufferSubData, once per frame.
+template <typename T>
+class MirroredBuffer {
+	private:
+		struct Range {
+			unsigned int begin;
+			unsigned int end;
+		};
+
+		GLenum target;
+		unsigned int buffer;
+		unsigned int capacity;
+		std::vector<T> items;
+		std::vector<Range> dirty;
+		UploadStats frameStats;
+		UploadStats totalStats;
+
+	public:
+		//ranges closer than this are uploaded as one, a few wasted bytes
+		//are cheaper than another call
+		unsigned int mergeGap;
+
+		MirroredBuffer (GLenum bufferTarget, unsigned int maxItems, GLenum usage = GL_DYNAMIC_DRAW) {
+			target = bufferTarget;
+			capacity = maxItems;
+			mergeGap = 256;
+			items.reserve(capacity);
+			frameStats = UploadStats();
+			totalStats = UploadStats();
+
+			glGenBuffers(1, &buffer);
+			glState.bindBuffer(target, buffer);
+			glBufferData(target, capacity * sizeof(T), NULL, usage);
+		}
+
+		void markDirty(unsigned int beginByte, unsigned int endByte) {
+			Range range = {beginByte, endByte};
+			dirty.push_back(range);
+			frameStats.rangesMarked++;
+		}
+
+		// returns the index of the new item, or -1 when full
+		int push(const T &item) {
+			if (items.size() >= capacity)
+				return -1;
+
+			items.push_back(item);
+			int index = items.size() - 1;
+			markDirty(index * sizeof(T), (index + 1) * sizeof(T));
+			return index;
+		}
+
+		void set(int index, const T &item) {
+			items[index] = item;
+			markDirty(index * sizeof(T), (index + 1) * sizeof(T));
+		}
+
+		// writable reference, the whole item is marked dirty
+		T &edit(int index) {
+			markDirty(index * sizeof(T), (index + 1) * sizeof(T));
+			return items[index];
+		}
+
+		// marks only [byteOffset, byteOffset + bytes) of the item, for edits
+		// that touch a single field
+		T &editPart(int index, unsigned int byteOffset, unsigned int bytes) {
+			unsigned int begin = index * sizeof(T) + byteOffset;
+			markDirty(begin, begin + bytes);
+			return items[index];
+		}
+
+		const T &operator[] (int index) const {
+			return items[index];
+		}
+
+		void flush() {
+			if (dirty.empty())
+				return;
+
+			std::sort(dirty.begin(), dirty.end(), [](const Range &a, const Range &b) {
+				return a.begin < b.begin;
+			});
+
+			glState.bindBuffer(target, buffer);
+			const char *bytes = (const char*)items.data();
+			Range current = dirty[0];
+			for (unsigned int i = 1; i <= dirty.size(); i++) {
+				if (i < dirty.size() && dirty[i].begin <= current.end + mergeGap) {
+					current.end = std::max(current.end, dirty[i].end);
+					continue;
+				}
+
+				glBufferSubData(target, current.begin, current.end - current.begin,
+						bytes + current.begin);
+				frameStats.bytesUploaded += current.end - current.begin;
+				frameStats.uploads++;
+
+				if (i < dirty.size())
+					current = dirty[i];
+			}
+			dirty.clear();
+		}
+
+		// drops the pending ranges, for when the data reached the gpu another way
+		void discardDirty() {
+			dirty.clear();
+		}
+
+		// call once per frame after flush(), starts a new stats frame
+		void endFrame() {
+			totalStats.bytesUploaded += frameStats.bytesUploaded;
+			totalStats.uploads += frameStats.uploads;
+			totalStats.rangesMarked += frameStats.rangesMarked;
+			frameStats = UploadStats();
+		}
+
+		const T *data() const {
+			return items.data();
+		}
+
+		int size() const {
+			return items.size();
+		}
+
+		unsigned int getBuffer() const {
+			return buffer;
+		}
+
+		const UploadStats &getFrameStats() const {
+			return frameStats;
+		}
+
+		const UploadStats &getTotalStats() const {
+			return totalStats;
+		}
+};
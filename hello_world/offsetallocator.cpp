@@ -0,0 +1,225 @@
+#pragma once
+
+#include <vector>
+
+struct Allocation {
+	unsigned int offset;
+	int node;     //-1 when the allocation failed
+};
+
+// Hands out ranges of an abstract [0, size) space, vertices or 4 byte index
+// words in the GeometryArena. Free ranges live in TLSF-style size classes:
+// eight linear classes below 8, then eight classes per power of two, with a
+// bitmap of the non-empty ones, so allocate and free never walk a list.
+// Neighbouring free ranges are merged on free.
+class OffsetAllocator {
+	private:
+		static const int binCount = 256;
+		static const int none = -1;
+
+		struct Node {
+			unsigned int offset;
+			unsigned int size;
+			int prevPhysical;
+			int nextPhysical;
+			int prevFree;
+			int nextFree;
+			bool used;
+		};
+
+		unsigned int capacity;
+		unsigned int freeSpace;
+		unsigned int allocations;
+		std::vector<Node> nodes;
+		std::vector<int> unusedNodes;
+		int binHeads[binCount];
+		unsigned long long binBits[binCount / 64];
+
+		static int log2Floor(unsigned int value) {
+			return 31 - __builtin_clz(value);
+		}
+
+		// class whose ranges are all at least as large as the smallest in it
+		static int binOf(unsigned int size) {
+			if (size < 8)
+				return size;
+			int top = log2Floor(size);
+			return (top - 2) * 8 + ((size >> (top - 3)) & 7);
+		}
+
+		// first class where every range fits size
+		static int binFitting(unsigned int size) {
+			if (size < 8)
+				return size;
+			int top = log2Floor(size);
+			unsigned long long rounded = (unsigned long long)size + (1u << (top - 3)) - 1;
+			if (rounded > 0xFFFFFFFFULL)
+				return binCount;
+			return binOf((unsigned int)rounded);
+		}
+
+		int newNode() {
+			if (!unusedNodes.empty()) {
+				int index = unusedNodes.back();
+				unusedNodes.pop_back();
+				return index;
+			}
+			nodes.push_back(Node());
+			return nodes.size() - 1;
+		}
+
+		void insertFree(int index) {
+			Node &node = nodes[index];
+			int bin = binOf(node.size);
+			node.used = false;
+			node.prevFree = none;
+			node.nextFree = binHeads[bin];
+			if (binHeads[bin] != none)
+				nodes[binHeads[bin]].prevFree = index;
+			binHeads[bin] = index;
+			binBits[bin / 64] |= 1ULL << (bin % 64);
+		}
+
+		void removeFree(int index) {
+			Node &node = nodes[index];
+			int bin = binOf(node.size);
+			if (node.prevFree != none)
+				nodes[node.prevFree].nextFree = node.nextFree;
+			else
+				binHeads[bin] = node.nextFree;
+			if (node.nextFree != none)
+				nodes[node.nextFree].prevFree = node.prevFree;
+			if (binHeads[bin] == none)
+				binBits[bin / 64] &= ~(1ULL << (bin % 64));
+		}
+
+		int firstNonEmptyBin(int from) {
+			for (int word = from / 64; word < binCount / 64; word++) {
+				unsigned long long bits = binBits[word];
+				if (word == from / 64)
+					bits &= ~0ULL << (from % 64);
+				if (bits != 0)
+					return word * 64 + __builtin_ctzll(bits);
+			}
+			return none;
+		}
+
+	public:
+		OffsetAllocator (unsigned int size = 0) {
+			reset(size);
+		}
+
+		void reset(unsigned int size) {
+			capacity = size;
+			freeSpace = size;
+			allocations = 0;
+			nodes.clear();
+			unusedNodes.clear();
+			for (int i = 0; i < binCount; i++)
+				binHeads[i] = none;
+			for (int i = 0; i < binCount / 64; i++)
+				binBits[i] = 0;
+			if (size == 0)
+				return;
+
+			int index = newNode();
+			Node &node = nodes[index];
+			node.offset = 0;
+			node.size = size;
+			node.prevPhysical = none;
+			node.nextPhysical = none;
+			insertFree(index);
+		}
+
+		Allocation allocate(unsigned int size) {
+			Allocation result = {0, none};
+			if (size == 0 || size > freeSpace)
+				return result;
+
+			int bin = binFitting(size);
+			if (bin >= binCount || (bin = firstNonEmptyBin(bin)) == none)
+				return result;
+
+			int index = binHeads[bin];
+			removeFree(index);
+			nodes[index].used = true;
+
+			//the tail goes back as a free range of its own
+			if (nodes[index].size > size) {
+				int rest = newNode();
+				Node &node = nodes[index];
+				Node &tail = nodes[rest];
+				tail.offset = node.offset + size;
+				tail.size = node.size - size;
+				tail.prevPhysical = index;
+				tail.nextPhysical = node.nextPhysical;
+				if (node.nextPhysical != none)
+					nodes[node.nextPhysical].prevPhysical = rest;
+				node.nextPhysical = rest;
+				node.size = size;
+				insertFree(rest);
+			}
+
+			freeSpace -= size;
+			allocations++;
+			result.offset = nodes[index].offset;
+			result.node = index;
+			return result;
+		}
+
+		void free(const Allocation &allocation) {
+			int index = allocation.node;
+			if (index == none || !nodes[index].used)
+				return;
+
+			freeSpace += nodes[index].size;
+			allocations--;
+
+			int prev = nodes[index].prevPhysical;
+			if (prev != none && !nodes[prev].used) {
+				removeFree(prev);
+				nodes[prev].size += nodes[index].size;
+				nodes[prev].nextPhysical = nodes[index].nextPhysical;
+				if (nodes[index].nextPhysical != none)
+					nodes[nodes[index].nextPhysical].prevPhysical = prev;
+				unusedNodes.push_back(index);
+				index = prev;
+			}
+
+			int next = nodes[index].nextPhysical;
+			if (next != none && !nodes[next].used) {
+				removeFree(next);
+				nodes[index].size += nodes[next].size;
+				nodes[index].nextPhysical = nodes[next].nextPhysical;
+				if (nodes[next].nextPhysical != none)
+					nodes[nodes[next].nextPhysical].prevPhysical = index;
+				unusedNodes.push_back(next);
+			}
+
+			insertFree(index);
+		}
+
+		unsigned int getCapacity() {
+			return capacity;
+		}
+
+		unsigned int getFreeSpace() {
+			return freeSpace;
+		}
+
+		unsigned int getAllocationCount() {
+			return allocations;
+		}
+
+		unsigned int largestFreeRange() {
+			for (int bin = binCount - 1; bin >= 0; bin--) {
+				if (binHeads[bin] == none)
+					continue;
+				unsigned int largest = 0;
+				for (int i = binHeads[bin]; i != none; i = nodes[i].nextFree)
+					largest = nodes[i].size > largest ? nodes[i].size : largest;
+				return largest;
+			}
+			return 0;
+		}
+};
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "picking.cpp"
+
+//./pickbench <triangles> <picks>
+//the game's triangles at random places in a PickGrid: times picks at
+//random points and moves of random triangles, then checks picks against
+//every triangle tested with a HitTester, topmost being the highest id
+
+float randomUnit() {
+	return rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+double elapsedNs(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+void place(PickGrid &grid, TriangleSet &triangles, int id) {
+	float x = randomUnit(), y = randomUnit();
+	grid.set(id, x, y, x + 0.2f, y, x + 0.1f, y + 0.17f);
+	triangles.set(id, x, y, x + 0.2f, y, x + 0.1f, y + 0.17f);
+}
+
+int main(int argc, char** argv) {
+	unsigned int count = argc > 1 ? atoi(argv[1]) : 100000;
+	unsigned int picks = argc > 2 ? atoi(argv[2]) : 100000;
+
+	srand(1);
+	PickGrid grid;
+	TriangleSet triangles;
+	for (unsigned int i = 0; i < count; i++) {
+		triangles.add(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+		place(grid, triangles, i);
+	}
+	std::vector<float> xs(picks), ys(picks);
+	for (unsigned int p = 0; p < picks; p++) {
+		xs[p] = randomUnit();
+		ys[p] = randomUnit();
+	}
+	std::cout << count << " triangles, " << grid.getEntryCount() << " cell entries" << std::endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	unsigned int hits = 0;
+	for (unsigned int p = 0; p < picks; p++)
+		hits += grid.pick(xs[p], ys[p]) >= 0;
+	double pickNs = elapsedNs(start);
+
+	unsigned int moves = picks < count ? picks : count;
+	start = std::chrono::steady_clock::now();
+	for (unsigned int m = 0; m < moves; m++)
+		place(grid, triangles, rand() % count);
+	double moveNs = elapsedNs(start);
+	std::cout << "pick: " << pickNs / picks << " ns, " << hits << " of " << picks << " hit" << std::endl;
+	std::cout << "move: " << moveNs / moves << " ns (grid and TriangleSet)" << std::endl;
+
+	//a few hundred points on shared edges and corners of a tiling on top,
+	//the rest random
+	for (int row = 0; row < 8; row++) {
+		for (int column = 0; column < 8; column++) {
+			float x0 = column / 4.0f - 1.0f, y0 = row / 4.0f - 1.0f;
+			float x1 = x0 + 0.25f, y1 = y0 + 0.25f;
+			grid.set(triangles.size(), x0, y0, x1, y0, x1, y1);
+			triangles.add(x0, y0, x1, y0, x1, y1);
+			grid.set(triangles.size(), x0, y0, x1, y1, x0, y1);
+			triangles.add(x0, y0, x1, y1, x0, y1);
+		}
+	}
+	HitTester tester;
+	std::vector<unsigned char> mask(triangles.maskBytes());
+	unsigned int wrong = 0, checked = 0;
+	for (int p = 0; p < 1000; p++) {
+		float x = p < 289 ? (p % 17) / 8.0f - 1.0f : randomUnit();
+		float y = p < 289 ? (p / 17) / 8.0f - 1.0f : randomUnit();
+		tester.test(triangles, x, y, mask.data());
+		int topmost = -1;
+		for (int i = (int)triangles.size() - 1; i >= 0 && topmost < 0; i--) {
+			if (mask[i / 8] & (1 << (i % 8)))
+				topmost = i;
+		}
+		wrong += grid.pick(x, y) != topmost;
+		checked++;
+	}
+	std::cout << "check: " << wrong << " of " << checked << " picks differ from the hit test" << std::endl;
+	return wrong > 0 ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "hittest.cpp"
+
+// cursor position (window coordinates, y down) to NDC. The viewport covers
+// the whole framebuffer, which on high dpi screens has more pixels than the
+// window has units, so the cursor is scaled to framebuffer pixels first.
+inline void windowToNdc(double cursorX, double cursorY, int windowWidth, int windowHeight,
+		int framebufferWidth, int framebufferHeight, float &x, float &y) {
+	double pixelX = cursorX * framebufferWidth / windowWidth;
+	double pixelY = cursorY * framebufferHeight / windowHeight;
+	x = (float)(pixelX / framebufferWidth * 2.0 - 1.0);
+	y = (float)(1.0 - pixelY / framebufferHeight * 2.0);
+}
+
+// false while the window is minimized
+inline bool cursorToNdc(GLFWwindow *window, float &x, float &y) {
+	double cursorX, cursorY;
+	int windowWidth, windowHeight, framebufferWidth, framebufferHeight;
+	glfwGetCursorPos(window, &cursorX, &cursorY);
+	glfwGetWindowSize(window, &windowWidth, &windowHeight);
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	if (windowWidth <= 0 || windowHeight <= 0 || framebufferWidth <= 0 || framebufferHeight <= 0)
+		return false;
+	windowToNdc(cursorX, cursorY, windowWidth, windowHeight, framebufferWidth, framebufferHeight, x, y);
+	return true;
+}
+
+// Triangles in a uniform grid for picking. Every triangle is listed in each
+// cell its bounding box overlaps, with a copy of its corners so a pick walks
+// one cell's array and never chases ids. Cells are sorted by id, and a
+// higher id is drawn later, so pick() tests from the back and the first hit
+// is the topmost one. Moving a triangle only touches the cells it leaves
+// and enters; one staying in the same cells is updated in place.
+//
+// The point test builds the entry's TriangleEdges from its corners, so a
+// point on an edge shared by two triangles goes to the one the top-left rule
+// gives it, exactly as in HitTester; degenerate triangles never hit. Corners
+// are half the size of the edges, which keeps moves cheap.
+class PickGrid {
+	private:
+		struct Entry {
+			int id;
+			float x[3];
+			float y[3];
+		};
+
+		struct CellRange {
+			int column0, row0, column1, row1;   //-1 when not in the grid
+		};
+
+		int columns;
+		int rows;
+		float minX;
+		float minY;
+		float cellsPerUnitX;
+		float cellsPerUnitY;
+		std::vector<std::vector<Entry> > cells;
+		std::vector<CellRange> placed;
+		unsigned int entries;
+
+		int column(float x) const {
+			int c = (int)((x - minX) * cellsPerUnitX);
+			return c < 0 ? 0 : (c >= columns ? columns - 1 : c);
+		}
+
+		int row(float y) const {
+			int r = (int)((y - minY) * cellsPerUnitY);
+			return r < 0 ? 0 : (r >= rows ? rows - 1 : r);
+		}
+
+		static bool byId(const Entry &entry, int id) {
+			return entry.id < id;
+		}
+
+		void removeFrom(int id, const CellRange &range) {
+			for (int r = range.row0; r <= range.row1; r++) {
+				for (int c = range.column0; c <= range.column1; c++) {
+					std::vector<Entry> &cell = cells[r * columns + c];
+					std::vector<Entry>::iterator it = std::lower_bound(cell.begin(), cell.end(), id, byId);
+					cell.erase(it);
+					entries--;
+				}
+			}
+		}
+
+	public:
+		PickGrid (int gridColumns = 64, int gridRows = 64, float left = -1.0f, float bottom = -1.0f,
+				float right = 1.0f, float top = 1.0f) {
+			columns = gridColumns;
+			rows = gridRows;
+			minX = left;
+			minY = bottom;
+			cellsPerUnitX = columns / (right - left);
+			cellsPerUnitY = rows / (top - bottom);
+			cells.resize(columns * rows);
+			entries = 0;
+		}
+
+		// adds triangle id or moves it to the new corners
+		void set(int id, float ax, float ay, float bx, float by, float cx, float cy) {
+			Entry entry = {id, {ax, bx, cx}, {ay, by, cy}};
+
+			CellRange range;
+			range.column0 = column(std::min(ax, std::min(bx, cx)));
+			range.column1 = column(std::max(ax, std::max(bx, cx)));
+			range.row0 = row(std::min(ay, std::min(by, cy)));
+			range.row1 = row(std::max(ay, std::max(by, cy)));
+
+			if (id >= (int)placed.size()) {
+				CellRange none = {-1, -1, -1, -1};
+				placed.resize(id + 1, none);
+			}
+			CellRange &old = placed[id];
+			bool same = old.column0 == range.column0 && old.column1 == range.column1
+				&& old.row0 == range.row0 && old.row1 == range.row1;
+			if (!same && old.column0 >= 0)
+				removeFrom(id, old);
+
+			for (int r = range.row0; r <= range.row1; r++) {
+				for (int c = range.column0; c <= range.column1; c++) {
+					std::vector<Entry> &cell = cells[r * columns + c];
+					std::vector<Entry>::iterator it = std::lower_bound(cell.begin(), cell.end(), id, byId);
+					if (same) {
+						*it = entry;
+					} else {
+						cell.insert(it, entry);
+						entries++;
+					}
+				}
+			}
+			old = range;
+		}
+
+		void remove(int id) {
+			if (id >= (int)placed.size() || placed[id].column0 < 0)
+				return;
+			removeFrom(id, placed[id]);
+			placed[id].column0 = -1;
+		}
+
+		// topmost triangle under the point, -1 for none
+		int pick(float x, float y) const {
+			if (x < minX || y < minY || x > minX + columns / cellsPerUnitX || y > minY + rows / cellsPerUnitY)
+				return -1;
+
+			const std::vector<Entry> &cell = cells[row(y) * columns + column(x)];
+			for (int i = (int)cell.size() - 1; i >= 0; i--) {
+				const Entry &e = cell[i];
+				if (TriangleEdges::of(e.x[0], e.y[0], e.x[1], e.y[1], e.x[2], e.y[2]).contains(x, y))
+					return e.id;
+			}
+			return -1;
+		}
+
+		// cell entries over all triangles, a triangle counts once per cell
+		unsigned int getEntryCount() const {
+			return entries;
+		}
+};
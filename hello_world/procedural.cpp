@@ -0,0 +1,137 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cmath>
+#include <cstddef>
+
+#include "statecache.cpp"
+#include "mirroredbuffer.cpp"
+#include "shader.cpp"
+#include "vertexformat.cpp"
+
+// One shape for the vertex-pulling renderer, 16 bytes, read in the vertex
+// shader as a single RGBA32UI texel:
+//   center    int16 normalized, times 2 (NDC -2..2)
+//   size      uint16 normalized, times 2: radius along x and y
+//   rotation  uint16 normalized, times 2*pi
+//   sides     3 and up, a regular polygon
+//   color     RGBA8
+struct ShapeRecord {
+	short center[2];
+	unsigned short size[2];
+	unsigned short rotation;
+	unsigned char sides;
+	unsigned char unused;
+	unsigned char color[4];
+};
+
+static_assert(sizeof(ShapeRecord) == 16, "ShapeRecord is one RGBA32UI texel");
+
+inline ShapeRecord makeShape(float x, float y, float radiusX, float radiusY, float rotation,
+		int sides, const unsigned char color[4]) {
+	const float twoPi = 6.28318530718f;
+	ShapeRecord shape;
+	shape.center[0] = snorm16(x * 0.5f);
+	shape.center[1] = snorm16(y * 0.5f);
+	shape.size[0] = (unsigned short)std::lround(fminf(fmaxf(radiusX * 0.5f, 0.0f), 1.0f) * 65535.0f);
+	shape.size[1] = (unsigned short)std::lround(fminf(fmaxf(radiusY * 0.5f, 0.0f), 1.0f) * 65535.0f);
+	rotation = fmodf(rotation, twoPi);
+	if (rotation < 0.0f)
+		rotation += twoPi;
+	shape.rotation = (unsigned short)std::lround(rotation / twoPi * 65535.0f);
+	shape.sides = sides < 3 ? 3 : sides;
+	shape.unused = 0;
+	for (int i = 0; i < 4; i++)
+		shape.color[i] = color[i];
+	return shape;
+}
+
+// Draws shapes whose corners are made in the vertex shader (shape.vs with
+// PULLED): per shape only its ShapeRecord is uploaded, to a texture buffer,
+// and gl_VertexID picks the shape and the corner. A polygon is a fan of
+// sides - 2 triangles; every shape gets the vertices of the largest one in
+// use and smaller ones collapse the triangles they do not need, so keep
+// shapes with many sides in their own renderer. No vertex attributes at
+// all, the VAO is empty.
+class ShapeRenderer {
+	private:
+		MirroredBuffer<ShapeRecord> shapes;
+		unsigned int texture;
+		unsigned int VAO;
+		int maxSides;
+		unsigned int generation;
+		int shapesHandle;
+		int maxSidesHandle;
+		ProgramShader *lookedUp;
+
+		void trackSides(const ShapeRecord &shape) {
+			if (shape.sides > maxSides)
+				maxSides = shape.sides;
+		}
+
+	public:
+		ShapeRenderer (unsigned int capacity) : shapes(GL_TEXTURE_BUFFER, capacity) {
+			maxSides = 3;
+			generation = 0;
+			lookedUp = NULL;
+			glGenVertexArrays(1, &VAO);
+
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_BUFFER, texture);
+			glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, shapes.getBuffer());
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		}
+
+		// returns the index of the new shape, or -1 when full
+		int add(const ShapeRecord &shape) {
+			trackSides(shape);
+			return shapes.push(shape);
+		}
+
+		void set(int index, const ShapeRecord &shape) {
+			trackSides(shape);
+			shapes.set(index, shape);
+		}
+
+		const ShapeRecord &get(int index) const {
+			return shapes[index];
+		}
+
+		int size() const {
+			return shapes.size();
+		}
+
+		int verticesPerShape() const {
+			return 3 * (maxSides - 2);
+		}
+
+		const UploadStats &getUploadStats() const {
+			return shapes.getTotalStats();
+		}
+
+		void draw(ProgramShader &program) {
+			if (shapes.size() == 0)
+				return;
+
+			if (lookedUp != &program || generation != program.getGeneration()) {
+				shapesHandle = program.uniformHandle("uShapes");
+				maxSidesHandle = program.uniformHandle("uMaxSides");
+				generation = program.getGeneration();
+				lookedUp = &program;
+			}
+
+			shapes.flush();
+			shapes.endFrame();
+
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_BUFFER, texture);
+			program.setUniform(shapesHandle, 0);
+			program.setUniform(maxSidesHandle, maxSides);
+
+			glState.useProgram(program.getProgram());
+			glState.bindVertexArray(VAO);
+			glDrawArrays(GL_TRIANGLES, 0, shapes.size() * verticesPerShape());
+		}
+};
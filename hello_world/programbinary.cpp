@@ -0,0 +1,147 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+//GL_ARB_get_program_binary, core in 4.1, so glad (3.3) does not load it
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum format, const void *binary, GLsizei length);
+typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei *length,
+		GLenum *format, void *binary);
+typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+// Linked program binaries on disk, one file per hash of the shader sources and
+// the driver strings, so a driver update or a shader edit is simply a miss.
+//   shadercache/<hash>.bin : GLenum format, then the driver's binary blob
+class ProgramBinaryCache {
+	private:
+		bool checked;
+		bool supported;
+		std::string directory;
+		ProgramBinaryProc programBinary;
+		GetProgramBinaryProc getProgramBinary;
+		ProgramParameteriProc programParameteri;
+
+		std::string pathFor(unsigned long long hash) {
+			char name[32];
+			snprintf(name, sizeof(name), "%016llx.bin", hash);
+			return directory + "/" + name;
+		}
+
+	public:
+		static void hashString(unsigned long long &hash, const char *str) {
+			//FNV-1a, the terminator is hashed too so "ab"+"c" != "a"+"bc"
+			if (str == NULL)
+				str = "";
+			do {
+				hash ^= (unsigned char)*str;
+				hash *= 1099511628211ULL;
+			} while (*str++ != '\0');
+		}
+
+		ProgramBinaryCache (const char *cacheDirectory = "shadercache") {
+			checked = false;
+			supported = false;
+			directory = cacheDirectory;
+			programBinary = NULL;
+			getProgramBinary = NULL;
+			programParameteri = NULL;
+		}
+
+		// needs a current context, resolved on first use
+		bool isSupported() {
+			if (checked)
+				return supported;
+			checked = true;
+
+			if (!glfwExtensionSupported("GL_ARB_get_program_binary"))
+				return false;
+
+			programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+			getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+			programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+
+			int formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			supported = programBinary != NULL && getProgramBinary != NULL
+				&& programParameteri != NULL && formats > 0;
+			return supported;
+		}
+
+		unsigned long long hashSources(const char *vertexSrc, const char *fragmentSrc) {
+			unsigned long long hash = 14695981039346656037ULL;
+			hashString(hash, vertexSrc);
+			hashString(hash, fragmentSrc);
+			hashString(hash, (const char*)glGetString(GL_VENDOR));
+			hashString(hash, (const char*)glGetString(GL_RENDERER));
+			hashString(hash, (const char*)glGetString(GL_VERSION));
+			return hash;
+		}
+
+		// loads the stored binary into program, false if missing or rejected
+		bool load(unsigned int program, unsigned long long hash) {
+			if (!isSupported())
+				return false;
+
+			std::ifstream file(pathFor(hash).c_str(), std::ios::binary);
+			if (!file)
+				return false;
+
+			GLenum format;
+			file.read((char*)&format, sizeof(format));
+			if (!file)
+				return false;
+
+			std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			if (binary.empty())
+				return false;
+
+			programBinary(program, format, binary.data(), binary.size());
+			int success;
+			glGetProgramiv(program, GL_LINK_STATUS, &success);
+			return success;
+		}
+
+		// call before glLinkProgram so the driver keeps the binary around
+		void markRetrievable(unsigned int program) {
+			if (isSupported())
+				programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
+		void store(unsigned int program, unsigned long long hash) {
+			if (!isSupported())
+				return;
+
+			int length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+				return;
+
+			std::vector<char> binary(length);
+			GLenum format;
+			getProgramBinary(program, length, &length, &format, binary.data());
+
+			mkdir(directory.c_str(), 0755);
+			std::ofstream file(pathFor(hash).c_str(), std::ios::binary | std::ios::trunc);
+			file.write((const char*)&format, sizeof(format));
+			file.write(binary.data(), length);
+		}
+};
+
+static ProgramBinaryCache programBinaryCache;
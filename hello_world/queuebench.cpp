@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "renderqueue.cpp"
+
+//./queuebench <packets> <repeats>
+//sorts a queue of packets with random keys, once with keys spread over
+//every field and once with a scene's few layers and programs, checks the
+//order against std::stable_sort and compares the time with it
+unsigned long long randomKey(bool sceneLike) {
+	if (sceneLike)
+		return makeDrawKey(rand() % 3, rand() % 8, rand() % 32, rand() % 64, rand() / (float)RAND_MAX);
+	return (unsigned long long)rand() << 62 ^ (unsigned long long)rand() << 31 ^ (unsigned long long)rand();
+}
+
+int main(int argc, char** argv) {
+	unsigned int count = argc > 1 ? atoi(argv[1]) : 100000;
+	int repeats = argc > 2 ? atoi(argv[2]) : 50;
+
+	srand(1);
+	int failures = 0;
+	for (int sceneLike = 0; sceneLike < 2; sceneLike++) {
+		std::vector<DrawPacket> packets(count);
+		for (unsigned int i = 0; i < count; i++) {
+			memset(&packets[i], 0, sizeof(DrawPacket));
+			packets[i].key = randomKey(sceneLike != 0);
+		}
+
+		//the queue is emptied by execute() only, sort() can run again
+		RenderQueue queue;
+		for (unsigned int i = 0; i < count; i++)
+			queue.submit(packets[i]);
+		queue.sort();
+		double best = 1e30, total = 0.0;
+		for (int r = 0; r < repeats; r++) {
+			queue.sort();
+			best = std::min(best, queue.getSortMicroseconds());
+			total += queue.getSortMicroseconds();
+		}
+
+		//equal keys keep submission order, like a stable sort
+		std::vector<unsigned int> expected(count);
+		for (unsigned int i = 0; i < count; i++)
+			expected[i] = i;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::stable_sort(expected.begin(), expected.end(), [&packets](unsigned int a, unsigned int b) {
+			return packets[a].key < packets[b].key;
+		});
+		double stdMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+		bool same = queue.sortedOrder() == expected;
+		std::cout << count << " packets, " << (sceneLike ? "scene keys" : "random keys") << ": "
+			<< best << " us best, " << total / repeats << " us average, std::stable_sort "
+			<< stdMicroseconds << " us" << (same ? "" : " MISMATCH") << std::endl;
+		if (!same)
+			failures++;
+	}
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "cpufeatures.cpp"
+
+// seeds the generators: every call gives the next of a well mixed sequence
+inline unsigned long long splitMix64(unsigned long long &state) {
+	unsigned long long z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// 24 random bits to a float in [0, 1)
+inline float unitFloat(unsigned int bits) {
+	return (bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// xoshiro128+: 16 bytes of state, a few adds, shifts and xors a number.
+// Good for floats, which only use the high bits; the low bits are weaker.
+class Random {
+	private:
+		unsigned int s[4];
+
+		static unsigned int rotl(unsigned int x, int k) {
+			return (x << k) | (x >> (32 - k));
+		}
+
+	public:
+		Random (unsigned long long seed = 1) {
+			this->seed(seed);
+		}
+
+		void seed(unsigned long long seed) {
+			unsigned long long state = seed;
+			unsigned long long a = splitMix64(state), b = splitMix64(state);
+			s[0] = (unsigned int)a;
+			s[1] = (unsigned int)(a >> 32);
+			s[2] = (unsigned int)b;
+			s[3] = (unsigned int)(b >> 32);
+		}
+
+		unsigned int next() {
+			unsigned int result = s[0] + s[3];
+			unsigned int t = s[1] << 9;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3] = rotl(s[3], 11);
+			return result;
+		}
+
+		unsigned long long next64() {
+			unsigned long long high = next();
+			return high << 32 | next();
+		}
+
+		// [0, 1)
+		float nextFloat() {
+			return unitFloat(next());
+		}
+
+		// [min, max)
+		float range(float min, float max) {
+			return min + nextFloat() * (max - min);
+		}
+};
+
+// Eight xoshiro128+ generators side by side for filling arrays; one AVX2
+// register or two SSE2 registers step all eight at once. Every kernel
+// produces the same numbers in the same order, so a seed gives the same
+// shapes on any cpu.
+class RandomBatch {
+	private:
+		static const int lanes = 8;
+		alignas(32) unsigned int s[4][lanes];
+		SimdLevel kernel;
+
+		//one step of all lanes, eight floats in [min, max) to out
+		void stepScalar(float *out, float min, float size) {
+			for (int lane = 0; lane < lanes; lane++) {
+				unsigned int result = s[0][lane] + s[3][lane];
+				unsigned int t = s[1][lane] << 9;
+				s[2][lane] ^= s[0][lane];
+				s[3][lane] ^= s[1][lane];
+				s[1][lane] ^= s[2][lane];
+				s[0][lane] ^= s[3][lane];
+				s[2][lane] ^= t;
+				s[3][lane] = (s[3][lane] << 11) | (s[3][lane] >> 21);
+				out[lane] = min + unitFloat(result) * size;
+			}
+		}
+
+#ifdef SIMD_X86
+		__attribute__((target("sse2")))
+		void fillSSE(float *out, unsigned int steps, float min, float size) {
+			__m128 low = _mm_set1_ps(min), scale = _mm_set1_ps(size), unit = _mm_set1_ps(1.0f / 16777216.0f);
+			for (int half = 0; half < 2; half++) {
+				__m128i s0 = _mm_load_si128((__m128i*)&s[0][half * 4]);
+				__m128i s1 = _mm_load_si128((__m128i*)&s[1][half * 4]);
+				__m128i s2 = _mm_load_si128((__m128i*)&s[2][half * 4]);
+				__m128i s3 = _mm_load_si128((__m128i*)&s[3][half * 4]);
+				for (unsigned int i = 0; i < steps; i++) {
+					__m128i result = _mm_add_epi32(s0, s3);
+					__m128i t = _mm_slli_epi32(s1, 9);
+					s2 = _mm_xor_si128(s2, s0);
+					s3 = _mm_xor_si128(s3, s1);
+					s1 = _mm_xor_si128(s1, s2);
+					s0 = _mm_xor_si128(s0, s3);
+					s2 = _mm_xor_si128(s2, t);
+					s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+					__m128 u = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)), unit);
+					_mm_storeu_ps(out + i * lanes + half * 4, _mm_add_ps(low, _mm_mul_ps(u, scale)));
+				}
+				_mm_store_si128((__m128i*)&s[0][half * 4], s0);
+				_mm_store_si128((__m128i*)&s[1][half * 4], s1);
+				_mm_store_si128((__m128i*)&s[2][half * 4], s2);
+				_mm_store_si128((__m128i*)&s[3][half * 4], s3);
+			}
+		}
+
+		__attribute__((target("avx2")))
+		void fillAVX2(float *out, unsigned int steps, float min, float size) {
+			__m256 low = _mm256_set1_ps(min), scale = _mm256_set1_ps(size), unit = _mm256_set1_ps(1.0f / 16777216.0f);
+			__m256i s0 = _mm256_load_si256((__m256i*)s[0]);
+			__m256i s1 = _mm256_load_si256((__m256i*)s[1]);
+			__m256i s2 = _mm256_load_si256((__m256i*)s[2]);
+			__m256i s3 = _mm256_load_si256((__m256i*)s[3]);
+			for (unsigned int i = 0; i < steps; i++) {
+				__m256i result = _mm256_add_epi32(s0, s3);
+				__m256i t = _mm256_slli_epi32(s1, 9);
+				s2 = _mm256_xor_si256(s2, s0);
+				s3 = _mm256_xor_si256(s3, s1);
+				s1 = _mm256_xor_si256(s1, s2);
+				s0 = _mm256_xor_si256(s0, s3);
+				s2 = _mm256_xor_si256(s2, t);
+				s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+				//mul then add like the scalar path, fma would round differently
+				__m256 u = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(result, 8)), unit);
+				_mm256_storeu_ps(out + i * lanes, _mm256_add_ps(low, _mm256_mul_ps(u, scale)));
+			}
+			_mm256_store_si256((__m256i*)s[0], s0);
+			_mm256_store_si256((__m256i*)s[1], s1);
+			_mm256_store_si256((__m256i*)s[2], s2);
+			_mm256_store_si256((__m256i*)s[3], s3);
+		}
+#endif
+
+	public:
+		RandomBatch (unsigned long long seed = 1, SimdLevel requested = SimdAuto) {
+			kernel = chooseSimd(requested);
+			this->seed(seed);
+		}
+
+		void seed(unsigned long long seed) {
+			unsigned long long state = seed;
+			for (int lane = 0; lane < lanes; lane++) {
+				unsigned long long a = splitMix64(state), b = splitMix64(state);
+				s[0][lane] = (unsigned int)a;
+				s[1][lane] = (unsigned int)(a >> 32);
+				s[2][lane] = (unsigned int)b;
+				s[3][lane] = (unsigned int)(b >> 32);
+			}
+		}
+
+		// count floats in [min, max)
+		void fill(float *out, unsigned int count, float min, float max) {
+			float size = max - min;
+			unsigned int steps = count / lanes;
+#ifdef SIMD_X86
+			if (kernel == SimdAVX2)
+				fillAVX2(out, steps, min, size);
+			else if (kernel == SimdSSE2)
+				fillSSE(out, steps, min, size);
+			else
+#endif
+			for (unsigned int i = 0; i < steps; i++)
+				stepScalar(out + i * lanes, min, size);
+
+			if (count % lanes != 0) {
+				float rest[lanes];
+				stepScalar(rest, min, size);
+				for (unsigned int i = 0; i < count % lanes; i++)
+					out[steps * lanes + i] = rest[i];
+			}
+		}
+
+		SimdLevel getKernel() const {
+			return kernel;
+		}
+};
+
+// One seed for the whole program. Every thread gets its own Random, seeded
+// from the global seed and the order in which threads first asked for one:
+// the main thread asking first is generator 0, so a run repeats exactly as
+// long as threads start drawing numbers in the same order. seedRandom()
+// restarts all of them, including ones already handed out.
+static unsigned long long randomSeed = 1;
+static std::atomic<unsigned int> randomGeneration(1);
+static std::atomic<unsigned int> randomThreads(0);
+
+inline void seedRandom(unsigned long long seed) {
+	randomSeed = seed;
+	randomThreads = 0;
+	randomGeneration++;
+}
+
+inline unsigned long long getRandomSeed() {
+	return randomSeed;
+}
+
+inline Random &threadRandom() {
+	thread_local Random random;
+	thread_local unsigned int generation = 0;
+	if (generation != randomGeneration) {
+		unsigned long long state = randomSeed + randomThreads++ * 0xD1B54A32D192ED03ULL;
+		random.seed(splitMix64(state));
+		generation = randomGeneration;
+	}
+	return random;
+}
+
+// count floats in [min, max) from this thread's generator, in bulk
+inline void randomFill(float *out, unsigned int count, float min, float max) {
+	RandomBatch batch(threadRandom().next64());
+	batch.fill(out, count, min, max);
+}
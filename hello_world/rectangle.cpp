@@ -3,24 +3,12 @@
 
 #include <iostream>
 
+#include "shader.cpp"
+#include "vertexformat.cpp"
+#include "meshoptimizer.cpp"
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
-const char *vertexShaderSource = 
-	"#version 330 core\n"
-    	"layout (location = 0) in vec3 aPos;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   gl_Position = vec4(aPos.x, aPos.y, aPos.z, 1.0);\n"
-    	"}\0";
-
-
-const char *fragmentShaderSource = 
-	"#version 330 core\n"
-    	"out vec4 FragColor;\n"
-    	"void main()\n"
-    	"{\n"
-    	"   FragColor = vec4(1.0f, 0.8f, 0.6f, 1.0f);\n"
-    	"}\0";
 
 int main() {
 
@@ -61,6 +49,10 @@ int main() {
     	     1, 2, 3
 	};
 
+	//16 bit indices and cache friendly order, the welding is a no-op here
+	OptimizedMesh mesh = MeshOptimizer::build(vertices, 4, VertexFormat<Float3>::stride, indices, 6);
+	MeshOptimizer::print("rectangle", mesh.report);
+
 	//vertex array object
 	unsigned int VAO;
 	glGenVertexArrays(1, &VAO); 
@@ -70,55 +62,23 @@ int main() {
 	unsigned int VBO;
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size(), mesh.vertices.data(), GL_STATIC_DRAW);
 
 	//element buffer object
 	unsigned int EBO;
 	glGenBuffers(1, &EBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	//vertex shader 
-	unsigned int vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	int  success;
-	char infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-
-	if(!success){
-	    glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	//fragment shader
-	unsigned int fragmentShader;
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if(!success){
-	    glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-	    std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size(), mesh.indices.data(), GL_STATIC_DRAW);
 
 	//Shader Program
-	unsigned int shaderProgram;
-	shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	//delete shader objects (no need for them anymore)
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	ProgramShader shader;
+	shader.loadFiles("shaders/shape.vs", "shaders/shape.fs");
+	shader.createShaders();
+	shader.createShaderProgram();
+	unsigned int shaderProgram = shader.getProgram();
 
 	//link input with vertex shader
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	VertexFormat<Float3>::setup(VBO);
 
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -134,7 +94,7 @@ int main() {
 		
 		glUseProgram(shaderProgram);
 		glBindVertexArray(VAO);
-		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.indexType, 0);
 
 		// swap buffers and poll IO events
 		glfwSwapBuffers(window);
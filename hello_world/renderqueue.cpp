@@ -0,0 +1,261 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "statecache.cpp"
+#include "material.cpp"
+#include "uniformbuffer.cpp"
+
+// One draw call and the state it needs. indexType 0 draws arrays, anything
+// else draws elements with first as the byte offset into the element buffer.
+// instances 0 is a plain draw. With a material its program and uniforms are
+// applied, otherwise program is used as is.
+struct DrawPacket {
+	unsigned long long key;
+	unsigned int program;
+	unsigned int vertexArray;
+	GLenum mode;
+	int first;
+	int count;
+	int instances;
+	GLenum indexType;
+	const Material *material;
+	int objectBlock;   //UniformRing block bound at ObjectDataBinding, -1 for none
+};
+
+// Sort key, most significant first:
+//   layer    8 bits   coarse pass ordering (background, world, ui)
+//   program  12 bits  draws sharing a program end up next to each other
+//   material 12 bits  then draws sharing uniforms
+//   VAO      12 bits  then draws sharing a VAO
+//   depth    20 bits  front to back inside a state group, depth in [0, 1]
+// Ids above 12 bits alias, which only costs some grouping.
+unsigned long long makeDrawKey(unsigned int layer, unsigned int program, unsigned int material,
+		unsigned int vertexArray, float depth) {
+	if (depth < 0.0f)
+		depth = 0.0f;
+	if (depth > 1.0f)
+		depth = 1.0f;
+	unsigned long long quantized = (unsigned long long)(depth * 1048575.0f);
+	return ((unsigned long long)(layer & 0xFF) << 56)
+		| ((unsigned long long)(program & 0xFFF) << 44)
+		| ((unsigned long long)(material & 0xFFF) << 32)
+		| ((unsigned long long)(vertexArray & 0xFFF) << 20)
+		| quantized;
+}
+
+// Scenes submit packets in any order, execute() radix sorts them by key once
+// and issues them through glState so repeated programs and VAOs are elided,
+// and materials of the same program only reload their uniforms.
+class RenderQueue {
+	private:
+		static const int digitBits = 11;
+
+		//bits [from, from + width) of a key land at [to, to + width)
+		struct BitRun {
+			int from;
+			int to;
+			unsigned long long mask;
+		};
+
+		std::vector<DrawPacket> packets;
+		std::vector<unsigned long long> keys;
+		std::vector<unsigned long long> keysTmp;
+		std::vector<unsigned long long> words;
+		std::vector<unsigned long long> wordsTmp;
+		std::vector<unsigned int> order;
+		std::vector<unsigned int> orderTmp;
+		std::vector<unsigned int> histograms;
+		double sortMicroseconds;
+
+		// Only the key bits that differ between packets decide the order.
+		// They are packed together above the packet index into one 64-bit
+		// word and those words are radix sorted, 11 bits a pass: a scene
+		// with a few layers, programs and materials takes four passes over
+		// 8 bytes a packet. False when the bits and the index need more
+		// than 64 bits.
+		bool sortPacked(unsigned int n) {
+			unsigned long long first = packets[0].key;
+			unsigned long long differing = 0;
+			for (unsigned int i = 1; i < n; i++)
+				differing |= packets[i].key ^ first;
+
+			BitRun runs[32];
+			int runCount = 0;
+			int keyBits = 0;
+			for (int bit = 0; bit < 64; ) {
+				if (((differing >> bit) & 1) == 0) {
+					bit++;
+					continue;
+				}
+				int end = bit;
+				while (end < 64 && ((differing >> end) & 1) != 0)
+					end++;
+				runs[runCount].from = bit;
+				runs[runCount].to = keyBits;
+				runs[runCount].mask = end - bit == 64 ? ~0ULL : (1ULL << (end - bit)) - 1;
+				keyBits += end - bit;
+				runCount++;
+				bit = end;
+			}
+
+			int indexBits = 0;
+			while ((1ULL << indexBits) < n)
+				indexBits++;
+			if (keyBits + indexBits > 64)
+				return false;
+
+			words.resize(n);
+			wordsTmp.resize(n);
+			for (unsigned int i = 0; i < n; i++) {
+				unsigned long long key = packets[i].key, packed = 0;
+				for (int r = 0; r < runCount; r++)
+					packed |= ((key >> runs[r].from) & runs[r].mask) << runs[r].to;
+				words[i] = packed << indexBits | i;
+			}
+
+			const unsigned int buckets = 1 << digitBits;
+			int passes = (keyBits + digitBits - 1) / digitBits;
+			histograms.assign(passes * buckets, 0);
+			for (unsigned int i = 0; i < n; i++) {
+				unsigned long long packed = words[i] >> indexBits;
+				for (int pass = 0; pass < passes; pass++)
+					histograms[pass * buckets + ((packed >> (pass * digitBits)) & (buckets - 1))]++;
+			}
+
+			for (int pass = 0; pass < passes; pass++) {
+				int shift = indexBits + pass * digitBits;
+				unsigned int *counts = &histograms[pass * buckets];
+				if (counts[(words[0] >> shift) & (buckets - 1)] == n)
+					continue;
+
+				unsigned int sum = 0;
+				for (unsigned int bucket = 0; bucket < buckets; bucket++) {
+					unsigned int count = counts[bucket];
+					counts[bucket] = sum;
+					sum += count;
+				}
+				for (unsigned int i = 0; i < n; i++) {
+					unsigned long long word = words[i];
+					wordsTmp[counts[(word >> shift) & (buckets - 1)]++] = word;
+				}
+				words.swap(wordsTmp);
+			}
+
+			unsigned long long indexMask = (1ULL << indexBits) - 1;
+			for (unsigned int i = 0; i < n; i++)
+				order[i] = (unsigned int)(words[i] & indexMask);
+			return true;
+		}
+
+		// LSD radix sort of (key, index) pairs, 8 bits per pass. All eight
+		// histograms come from one read of the keys and passes whose byte is
+		// the same for every key are skipped.
+		void sortPairs(unsigned int n) {
+			keys.resize(n);
+			keysTmp.resize(n);
+			orderTmp.resize(n);
+
+			unsigned int counts8[8][256];
+			memset(counts8, 0, sizeof(counts8));
+			for (unsigned int i = 0; i < n; i++) {
+				unsigned long long key = packets[i].key;
+				keys[i] = key;
+				order[i] = i;
+				for (int pass = 0; pass < 8; pass++)
+					counts8[pass][(key >> (pass * 8)) & 0xFF]++;
+			}
+
+			for (int pass = 0; pass < 8; pass++) {
+				unsigned int *counts = counts8[pass];
+				if (counts[(keys[0] >> (pass * 8)) & 0xFF] == n)
+					continue;
+
+				unsigned int sum = 0;
+				for (int bucket = 0; bucket < 256; bucket++) {
+					unsigned int count = counts[bucket];
+					counts[bucket] = sum;
+					sum += count;
+				}
+
+				int shift = pass * 8;
+				for (unsigned int i = 0; i < n; i++) {
+					unsigned int dst = counts[(keys[i] >> shift) & 0xFF]++;
+					keysTmp[dst] = keys[i];
+					orderTmp[dst] = order[i];
+				}
+				keys.swap(keysTmp);
+				order.swap(orderTmp);
+			}
+		}
+
+	public:
+		RenderQueue () {
+			sortMicroseconds = 0.0;
+		}
+
+		void submit(const DrawPacket &packet) {
+			packets.push_back(packet);
+		}
+
+		// stable radix sort by key into sortedOrder(); packed words when the
+		// differing key bits allow, (key, index) pairs otherwise
+		void sort() {
+			auto start = std::chrono::steady_clock::now();
+			unsigned int n = packets.size();
+			order.resize(n);
+			if (n > 0 && !sortPacked(n))
+				sortPairs(n);
+
+			std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+			sortMicroseconds = elapsed.count();
+		}
+
+		// ring holds the uniform blocks of this frame, already uploaded
+		void execute(UniformRing *ring = NULL) {
+			sort();
+			for (unsigned int i = 0; i < order.size(); i++) {
+				const DrawPacket &packet = packets[order[i]];
+				if (packet.material != NULL)
+					packet.material->apply();
+				else
+					glState.useProgram(packet.program);
+				glState.bindVertexArray(packet.vertexArray);
+				if (ring != NULL)
+					ring->bindObject(packet.objectBlock);
+
+				if (packet.indexType == 0) {
+					if (packet.instances > 0)
+						glDrawArraysInstanced(packet.mode, packet.first, packet.count, packet.instances);
+					else
+						glDrawArrays(packet.mode, packet.first, packet.count);
+				} else {
+					if (packet.instances > 0)
+						glDrawElementsInstanced(packet.mode, packet.count, packet.indexType,
+								(void*)(size_t)packet.first, packet.instances);
+					else
+						glDrawElements(packet.mode, packet.count, packet.indexType,
+								(void*)(size_t)packet.first);
+				}
+			}
+			packets.clear();
+		}
+
+		// sorted submission order of the last execute(), for inspection
+		const std::vector<unsigned int> &sortedOrder() {
+			return order;
+		}
+
+		double getSortMicroseconds() {
+			return sortMicroseconds;
+		}
+
+		unsigned int size() {
+			return packets.size();
+		}
+};
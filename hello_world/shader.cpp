@@ -1,37 +1,299 @@
+#pragma once
+
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "statecache.cpp"
+#include "programbinary.cpp"
+#include "shaderpreprocessor.cpp"
+#include "uniformtable.cpp"
+
 class ProgramShader {
 	private:
-		const char *vertexShaderSource;
-		const char *fragmentShaderSource;
+		std::string vertexShaderSource;
+		std::string fragmentShaderSource;
+		std::string vertexPath;
+		std::string fragmentPath;
+		std::vector<std::string> defines;
+		std::vector<std::string> dependencies;
+		std::vector<std::string> feedbackVaryings;
+		unsigned int generation;
 		unsigned int vertexShader;
 		unsigned int fragmentShader;
 		unsigned int shaderProgram;
+		unsigned long long sourceHash;
+		bool fromCache;
+		std::chrono::steady_clock::time_point buildStart;
+		double buildMilliseconds;
+		bool linked;
+		std::string infoLog;
+		std::atomic<bool> ready;
+		UniformTable uniforms;
+
+		void appendShaderLog(unsigned int shader, const char *stage) {
+			int success;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+			if (success)
+				return;
+
+			int length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			std::string log(length > 0 ? length : 1, '\0');
+			glGetShaderInfoLog(shader, log.size(), NULL, &log[0]);
+			infoLog += std::string("ERROR::SHADER::") + stage + "::COMPILATION_FAILED\n" + log.c_str() + "\n";
+		}
+
+		void appendProgramLog() {
+			int length = 0;
+			glGetProgramiv(shaderProgram, GL_INFO_LOG_LENGTH, &length);
+			std::string log(length > 0 ? length : 1, '\0');
+			glGetProgramInfoLog(shaderProgram, log.size(), NULL, &log[0]);
+			infoLog += std::string("ERROR::SHADER::PROGRAM::LINKING_FAILED\n") + log.c_str() + "\n";
+		}
 	public:
-		ProgramShader (char *vertexSrc, char *fragmentSrc) {
+		ProgramShader (const char *vertexSrc = "", const char *fragmentSrc = "") {
 			vertexShaderSource = vertexSrc;
 			fragmentShaderSource = fragmentSrc;
+			generation = 0;
+			vertexShader = 0;
+			fragmentShader = 0;
+			shaderProgram = 0;
+			fromCache = false;
+			buildMilliseconds = 0.0;
+			linked = false;
+			ready = false;
 		}
 
+		// tries the on-disk binary first, compiles only on a miss
 		void createShaders() {
+			buildStart = std::chrono::steady_clock::now();
+			shaderProgram = glCreateProgram();
+			//captured varyings are part of the linked program, so of its key too
+			std::string vertexKey = vertexShaderSource;
+			for (unsigned int i = 0; i < feedbackVaryings.size(); i++)
+				vertexKey += "\n//feedback " + feedbackVaryings[i];
+			sourceHash = programBinaryCache.hashSources(vertexKey.c_str(),
+					fragmentShaderSource.c_str());
+			fromCache = programBinaryCache.load(shaderProgram, sourceHash);
+			if (fromCache)
+				return;
+
+			const char *vertexSrc = vertexShaderSource.c_str();
 			vertexShader = glCreateShader(GL_VERTEX_SHADER);
-			glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+			glShaderSource(vertexShader, 1, &vertexSrc, NULL);
 			glCompileShader(vertexShader);
 
+			const char *fragmentSrc = fragmentShaderSource.c_str();
 			fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-			glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+			glShaderSource(fragmentShader, 1, &fragmentSrc, NULL);
 			glCompileShader(fragmentShader);
 		}
 
-		void createShaderProgram () {
-			shaderProgram = glCreateProgram();
+		// issues the link without asking for its result, so a driver that
+		// compiles in the background is not forced to finish here
+		void linkProgram() {
+			if (fromCache)
+				return;
+
 			glAttachShader(shaderProgram, vertexShader);
 			glAttachShader(shaderProgram, fragmentShader);
+			if (!feedbackVaryings.empty()) {
+				std::vector<const char*> names;
+				for (unsigned int i = 0; i < feedbackVaryings.size(); i++)
+					names.push_back(feedbackVaryings[i].c_str());
+				glTransformFeedbackVaryings(shaderProgram, names.size(), names.data(), GL_INTERLEAVED_ATTRIBS);
+			}
+			programBinaryCache.markRetrievable(shaderProgram);
 			glLinkProgram(shaderProgram);
+		}
+
+		// collects compile and link status and logs, blocks until the driver
+		// is done with the program
+		void finishProgram() {
+			if (!fromCache) {
+				appendShaderLog(vertexShader, "VERTEX");
+				appendShaderLog(fragmentShader, "FRAGMENT");
+
+				int success;
+				glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+				linked = success;
+				if (!linked)
+					appendProgramLog();
+
+				glDeleteShader(vertexShader);
+				glDeleteShader(fragmentShader);
+
+				if (linked)
+					programBinaryCache.store(shaderProgram, sourceHash);
+			} else {
+				linked = true;
+			}
+
+			if (linked)
+				uniforms.reflect(shaderProgram);
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - buildStart;
+			buildMilliseconds = elapsed.count();
+			if (!infoLog.empty())
+				std::cout << infoLog;
+		}
+
+		void createShaderProgram () {
+			linkProgram();
+			finishProgram();
+			ready = true;
+		}
+
+		// sources from files, paths relative to the working directory
+		// (the exercises run from hello_world/). Both go through the
+		// ShaderPreprocessor with the given defines; dependencies collects the
+		// files of both.
+		bool loadFiles(const char *vertexFile, const char *fragmentFile,
+				const std::vector<std::string> &permutation = std::vector<std::string>()) {
+			vertexPath = vertexFile;
+			fragmentPath = fragmentFile;
+			defines = permutation;
+			dependencies.clear();
+			vertexShaderSource.clear();
+			fragmentShaderSource.clear();
+			bool vertexOk = ShaderPreprocessor::process(vertexPath, defines, vertexShaderSource, dependencies);
+			bool fragmentOk = ShaderPreprocessor::process(fragmentPath, defines, fragmentShaderSource, dependencies);
+			return vertexOk && fragmentOk;
+		}
+
+		// vertex outputs written to the transform feedback buffer, interleaved
+		// in this order; set before createShaders
+		void setFeedbackVaryings(const std::vector<std::string> &varyings) {
+			feedbackVaryings = varyings;
+		}
+
+		// rereads the files and relinks into a new program. Only when that
+		// links is it swapped in and the old one deleted, a broken edit keeps
+		// the last good program running. Render thread only.
+		bool reload() {
+			if (vertexPath.empty())
+				return false;
+
+			std::string oldVertex = vertexShaderSource;
+			std::string oldFragment = fragmentShaderSource;
+			std::vector<std::string> oldDependencies = dependencies;
+			unsigned int oldProgram = shaderProgram;
+			bool oldLinked = linked;
+			if (!loadFiles(vertexPath.c_str(), fragmentPath.c_str(), defines)) {
+				vertexShaderSource = oldVertex;
+				fragmentShaderSource = oldFragment;
+				dependencies = oldDependencies;
+				return false;
+			}
+
+			infoLog.clear();
+			createShaders();
+			linkProgram();
+			finishProgram();
+			if (!linked) {
+				glDeleteProgram(shaderProgram);
+				shaderProgram = oldProgram;
+				vertexShaderSource = oldVertex;
+				fragmentShaderSource = oldFragment;
+				dependencies = oldDependencies;
+				linked = oldLinked;
+				return false;
+			}
+
+			glDeleteProgram(oldProgram);
+			generation++;
+			return true;
+		}
+
+		// bumped by every successful reload, anything caching uniform
+		// handles or locations of this program must look them up again
+		unsigned int getGeneration() {
+			return generation;
+		}
+
+		const std::string &getVertexPath() {
+			return vertexPath;
+		}
+
+		const std::string &getFragmentPath() {
+			return fragmentPath;
+		}
+
+		// every file the sources were built from, includes too
+		const std::vector<std::string> &getDependencies() {
+			return dependencies;
+		}
+
+		const std::vector<std::string> &getDefines() {
+			return defines;
+		}
+
+		const std::string &getVertexSource() {
+			return vertexShaderSource;
+		}
+
+		const std::string &getFragmentSource() {
+			return fragmentShaderSource;
+		}
+
+		// set by whoever finished the program, see ShaderCompiler
+		void markReady() {
+			ready = true;
+		}
+
+		// safe to draw with: compiled, linked and queried
+		bool isReady() {
+			return ready;
+		}
+
+		bool isLinked() {
+			return linked;
+		}
+
+		const std::string &getInfoLog() {
+			return infoLog;
+		}
+
+		unsigned int getProgram() {
+			return shaderProgram;
+		}
+
+		// look up once, outside the render loop
+		int uniformHandle(const char *name) {
+			return uniforms.handle(name);
+		}
+
+		int attributeLocation(const char *name) {
+			return uniforms.attributeLocation(name);
+		}
+
+		// skipped when the program already holds this value
+		template<typename T>
+		void setUniform(int handle, const T &value) {
+			uniforms.set(handle, value);
+		}
+
+		UniformTable &getUniforms() {
+			return uniforms;
+		}
+
+		void use() {
+			glState.useProgram(shaderProgram);
+		}
+
+		// true when the program came from the binary cache (warm start)
+		bool isFromCache() {
+			return fromCache;
+		}
 
-			glDeleteShader(vertexShader);
-			glDeleteShader(fragmentShader);
+		double getBuildMilliseconds() {
+			return buildMilliseconds;
 		}
 
 };
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "shader.cpp"
+#include "programbinary.cpp"
+
+//GL_KHR_parallel_shader_compile, not part of the glad 3.3 loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+typedef void (APIENTRYP MaxShaderCompilerThreadsProc)(GLuint count);
+
+// Builds programs without blocking the render loop. Submit every program up
+// front, call poll() once per frame and draw a program once isReady().
+//
+// With GL_KHR_parallel_shader_compile the driver compiles on its own threads
+// and we only ask GL_COMPLETION_STATUS_KHR, which never blocks. Otherwise a
+// worker thread owning a hidden context that shares objects with the main
+// one compiles and links, then leaves a fence the main thread polls.
+class ShaderCompiler {
+	private:
+		struct Job {
+			ProgramShader *program;
+			GLsync fence;
+			bool built;
+		};
+
+		bool parallelExtension;
+		GLFWwindow *workerWindow;
+		std::thread worker;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::deque<Job*> queue;
+		std::vector<Job*> pending;
+		bool stopping;
+
+		void workerLoop() {
+			glfwMakeContextCurrent(workerWindow);
+			while (true) {
+				Job *job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [this] { return stopping || !queue.empty(); });
+					if (stopping)
+						break;
+					job = queue.front();
+					queue.pop_front();
+				}
+
+				//ready is only flagged by poll() once the fence says the
+				//commands reached the gpu, the main context may not see it before
+				job->program->createShaders();
+				job->program->linkProgram();
+				job->program->finishProgram();
+				GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				glFlush();
+
+				std::lock_guard<std::mutex> lock(mutex);
+				job->fence = fence;
+				job->built = true;
+			}
+			glfwMakeContextCurrent(NULL);
+		}
+
+	public:
+		// window is the main window, its context must be current
+		ShaderCompiler (GLFWwindow *window) {
+			workerWindow = NULL;
+			stopping = false;
+
+			//resolve extension entry points here, the worker must not race on them
+			programBinaryCache.isSupported();
+
+			parallelExtension = glfwExtensionSupported("GL_KHR_parallel_shader_compile")
+				|| glfwExtensionSupported("GL_ARB_parallel_shader_compile");
+			if (parallelExtension) {
+				MaxShaderCompilerThreadsProc maxThreads = (MaxShaderCompilerThreadsProc)
+					glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+				if (maxThreads == NULL)
+					maxThreads = (MaxShaderCompilerThreadsProc)glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+				if (maxThreads != NULL)
+					maxThreads(0xFFFFFFFF);
+				return;
+			}
+
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			workerWindow = glfwCreateWindow(1, 1, "shader compiler", NULL, window);
+			glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+			glfwMakeContextCurrent(window);
+			if (workerWindow != NULL)
+				worker = std::thread(&ShaderCompiler::workerLoop, this);
+		}
+
+		~ShaderCompiler () {
+			shutdown();
+		}
+
+		// call before glfwTerminate
+		void shutdown() {
+			if (worker.joinable()) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+				wake.notify_one();
+				worker.join();
+			}
+			if (workerWindow != NULL) {
+				glfwDestroyWindow(workerWindow);
+				workerWindow = NULL;
+			}
+			for (unsigned int i = 0; i < pending.size(); i++)
+				delete pending[i];
+			pending.clear();
+		}
+
+		void submit(ProgramShader *program) {
+			Job *job = new Job();
+			job->program = program;
+			job->fence = 0;
+			job->built = false;
+			pending.push_back(job);
+
+			if (parallelExtension) {
+				program->createShaders();
+				program->linkProgram();
+			} else if (workerWindow != NULL) {
+				std::lock_guard<std::mutex> lock(mutex);
+				queue.push_back(job);
+				wake.notify_one();
+			} else {
+				//no way to go async, build it now
+				program->createShaders();
+				program->createShaderProgram();
+			}
+		}
+
+		// finishes the programs that are done, returns how many are left
+		int poll() {
+			for (unsigned int i = 0; i < pending.size(); ) {
+				Job *job = pending[i];
+				bool done = false;
+
+				if (parallelExtension) {
+					int complete = GL_TRUE;
+					if (!job->program->isFromCache())
+						glGetProgramiv(job->program->getProgram(), GL_COMPLETION_STATUS_KHR, &complete);
+					if (complete) {
+						job->program->finishProgram();
+						job->program->markReady();
+						done = true;
+					}
+				} else if (workerWindow == NULL) {
+					done = true;
+				} else {
+					std::lock_guard<std::mutex> lock(mutex);
+					if (job->built) {
+						GLenum result = glClientWaitSync(job->fence, 0, 0);
+						done = result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+						if (done) {
+							glDeleteSync(job->fence);
+							job->program->markReady();
+						}
+					}
+				}
+
+				if (done) {
+					delete job;
+					pending[i] = pending.back();
+					pending.pop_back();
+				} else {
+					i++;
+				}
+			}
+			return pending.size();
+		}
+
+		bool usesParallelExtension() {
+			return parallelExtension;
+		}
+};
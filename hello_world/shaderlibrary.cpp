@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.cpp"
+#include "shadercompiler.cpp"
+#include "programbinary.cpp"
+
+// Every program variant the scenes ask for, keyed by permutation: the two
+// shader files plus a set of defines (COLOR_FROM_UNIFORM, INSTANCED...).
+// Nothing is built up front, a permutation is preprocessed and compiled the
+// first time get() sees it, and only once. Permutations whose preprocessed
+// sources come out identical (copies of a file under another name) share one
+// program.
+class ShaderLibrary {
+	private:
+		ShaderCompiler *compiler;
+		std::deque<ProgramShader> shaders;
+		std::unordered_map<unsigned long long, ProgramShader*> byPermutation;
+		std::unordered_map<unsigned long long, ProgramShader*> bySource;
+		unsigned int requests;
+		unsigned int misses;
+
+		static const unsigned long long hashSeed = 14695981039346656037ULL;
+
+		//define order does not matter, {"A", "B"} and {"B", "A"} are one key
+		static unsigned long long permutationHash(const char *vertexFile, const char *fragmentFile,
+				std::vector<std::string> defines) {
+			std::sort(defines.begin(), defines.end());
+			unsigned long long hash = hashSeed;
+			ProgramBinaryCache::hashString(hash, vertexFile);
+			ProgramBinaryCache::hashString(hash, fragmentFile);
+			for (unsigned int i = 0; i < defines.size(); i++)
+				ProgramBinaryCache::hashString(hash, defines[i].c_str());
+			return hash;
+		}
+
+	public:
+		// with a compiler, new permutations are built in the background and
+		// must be checked with isReady() before drawing
+		ShaderLibrary (ShaderCompiler *shaderCompiler = NULL) {
+			compiler = shaderCompiler;
+			requests = 0;
+			misses = 0;
+		}
+
+		ProgramShader *get(const char *vertexFile, const char *fragmentFile,
+				const std::vector<std::string> &defines = std::vector<std::string>()) {
+			requests++;
+			unsigned long long key = permutationHash(vertexFile, fragmentFile, defines);
+			std::unordered_map<unsigned long long, ProgramShader*>::iterator found = byPermutation.find(key);
+			if (found != byPermutation.end())
+				return found->second;
+
+			misses++;
+			shaders.emplace_back();
+			ProgramShader *shader = &shaders.back();
+			shader->loadFiles(vertexFile, fragmentFile, defines);
+
+			unsigned long long source = hashSeed;
+			ProgramBinaryCache::hashString(source, shader->getVertexSource().c_str());
+			ProgramBinaryCache::hashString(source, shader->getFragmentSource().c_str());
+			found = bySource.find(source);
+			if (found != bySource.end()) {
+				shaders.pop_back();
+				byPermutation[key] = found->second;
+				return found->second;
+			}
+
+			if (compiler != NULL) {
+				compiler->submit(shader);
+			} else {
+				shader->createShaders();
+				shader->createShaderProgram();
+			}
+			byPermutation[key] = shader;
+			bySource[source] = shader;
+			return shader;
+		}
+
+		ProgramShader *getShader(unsigned int index) {
+			return &shaders[index];
+		}
+
+		// distinct programs, what was actually compiled
+		unsigned int programCount() {
+			return shaders.size();
+		}
+
+		unsigned int permutationCount() {
+			return byPermutation.size();
+		}
+
+		unsigned int getRequests() {
+			return requests;
+		}
+
+		unsigned int getMisses() {
+			return misses;
+		}
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// whole file as a string, empty if it cannot be read
+std::string readShaderFile(const std::string &path) {
+	std::ifstream file(path.c_str());
+	if (!file) {
+		std::cout << "ERROR::SHADER::FILE_NOT_READ " << path << std::endl;
+		return "";
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+// Expands a shader file before it is handed to GL:
+//   #include "file"  pasted in place, relative to the including file, each
+//                    file at most once so shared snippets can include each other
+//   defines          "NAME" or "NAME VALUE" injected right after #version
+// #line directives keep compile errors pointing at the real file and line;
+// the second number is the index of the file in the files list. One files
+// list can collect several stages, e.g. a program's vertex and fragment
+// shader: each stage still gets every file it includes, and a file shared
+// by both keeps one index.
+class ShaderPreprocessor {
+	private:
+		static const int maxDepth = 16;
+
+		static std::string directoryOf(const std::string &path) {
+			size_t slash = path.find_last_of('/');
+			return slash == std::string::npos ? "." : path.substr(0, slash);
+		}
+
+		static bool parseInclude(const std::string &line, std::string &name) {
+			size_t start = line.find_first_not_of(" \t");
+			if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+				return false;
+
+			size_t open = line.find('"', start + 8);
+			size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+			if (close == std::string::npos)
+				return false;
+
+			name = line.substr(open + 1, close - open - 1);
+			return true;
+		}
+
+		static int indexOf(const std::vector<std::string> &files, const std::string &path) {
+			for (unsigned int i = 0; i < files.size(); i++) {
+				if (files[i] == path)
+					return i;
+			}
+			return -1;
+		}
+
+		// included holds what this stage pasted already, files what every
+		// stage did
+		static bool expand(const std::string &path, std::string &out, std::vector<std::string> &files,
+				std::vector<std::string> &included, int depth) {
+			if (depth > maxDepth) {
+				std::cout << "ERROR::SHADER::INCLUDE_TOO_DEEP " << path << std::endl;
+				return false;
+			}
+
+			std::string source = readShaderFile(path);
+			if (source.empty())
+				return false;
+
+			included.push_back(path);
+			int fileIndex = indexOf(files, path);
+			if (fileIndex < 0) {
+				fileIndex = files.size();
+				files.push_back(path);
+			}
+
+			std::istringstream lines(source);
+			std::string line;
+			int lineNumber = 0;
+			while (std::getline(lines, line)) {
+				lineNumber++;
+				std::string name;
+				if (!parseInclude(line, name)) {
+					out += line;
+					out += '\n';
+					continue;
+				}
+
+				std::string includePath = directoryOf(path) + "/" + name;
+				if (indexOf(included, includePath) >= 0)
+					continue;
+
+				int includeIndex = indexOf(files, includePath);
+				out += "#line 1 " + std::to_string(includeIndex < 0 ? files.size() : includeIndex) + "\n";
+				if (!expand(includePath, out, files, included, depth + 1))
+					return false;
+				out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+			}
+			return true;
+		}
+
+	public:
+		// out receives the expanded source, files every file it was built
+		// from that is not in it yet
+		static bool process(const std::string &path, const std::vector<std::string> &defines,
+				std::string &out, std::vector<std::string> &files) {
+			std::string expanded;
+			std::vector<std::string> included;
+			if (!expand(path, expanded, files, included, 0))
+				return false;
+			std::string root = std::to_string(indexOf(files, path));
+
+			//defines go right after #version, which must stay the first line
+			std::string injected;
+			for (unsigned int i = 0; i < defines.size(); i++)
+				injected += "#define " + defines[i] + "\n";
+
+			size_t version = expanded.find("#version");
+			if (version == std::string::npos) {
+				out = injected + "#line 1 " + root + "\n" + expanded;
+			} else {
+				size_t lineEnd = expanded.find('\n', version);
+				if (lineEnd == std::string::npos)
+					lineEnd = expanded.size() - 1;
+				int versionLine = 1;
+				for (size_t i = 0; i < version; i++)
+					versionLine += expanded[i] == '\n';
+				out = expanded.substr(0, lineEnd + 1) + injected
+					+ "#line " + std::to_string(versionLine + 1) + " " + root + "\n"
+					+ expanded.substr(lineEnd + 1);
+			}
+			return true;
+		}
+};
@@ -0,0 +1,6 @@
+// per-frame constants, one block for every program (FrameDataBinding)
+layout (std140) uniform FrameData
+{
+   mat4 uViewProjection;
+   vec4 uTime;   // seconds, delta, frame number, blend between the last two ticks
+};
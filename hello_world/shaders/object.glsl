@@ -0,0 +1,5 @@
+// per-object constants, a range of the uniform ring (ObjectDataBinding)
+layout (std140) uniform ObjectData
+{
+   vec4 uObjectOffset;
+};
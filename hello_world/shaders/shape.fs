@@ -0,0 +1,26 @@
+#version 330 core
+#ifdef PICK_ID
+flat in uint vId;
+out uint FragId;
+void main()
+{
+   FragId = vId;
+}
+#else
+#if defined(INSTANCED) || defined(PULLED)
+in vec4 vColor;
+#elif defined(COLOR_FROM_UNIFORM)
+uniform vec4 uColor;
+#endif
+out vec4 FragColor;
+void main()
+{
+#if defined(INSTANCED) || defined(PULLED)
+   FragColor = vColor;
+#elif defined(COLOR_FROM_UNIFORM)
+   FragColor = uColor;
+#else
+   FragColor = vec4(1.0f, 0.8f, 0.6f, 1.0f);
+#endif
+}
+#endif
@@ -0,0 +1,5 @@
+// shared by every permutation of shape.vs
+vec4 placeShape(vec2 position, vec2 offset, vec2 scale)
+{
+   return vec4(offset + position * scale, 0.0, 1.0);
+}
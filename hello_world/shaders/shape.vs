@@ -0,0 +1,83 @@
+#version 330 core
+#include "shape.glsl"
+#ifdef FRAME_DATA
+#include "frame.glsl"
+#endif
+#ifdef OBJECT_DATA
+#include "object.glsl"
+#endif
+#if defined(PULLED)
+uniform usamplerBuffer uShapes;
+uniform int uMaxSides;
+out vec4 vColor;
+#elif defined(INSTANCED)
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aOffset;
+layout (location = 2) in vec2 aScale;
+layout (location = 3) in vec4 aColor;
+#ifdef INTERPOLATED
+// where the shape was one simulation tick earlier, needs FRAME_DATA
+layout (location = 4) in vec2 aPreviousOffset;
+#endif
+out vec4 vColor;
+#else
+layout (location = 0) in vec3 aPos;
+#endif
+#ifdef PICK_ID
+// shape index + 1 for the id target, 0 is the background (IdPicker)
+flat out uint vId;
+#endif
+#ifdef PULLED
+// corner of a regular polygon for gl_VertexID, see ShapeRenderer
+vec4 pullShape(out vec4 color)
+{
+   int verticesPerShape = 3 * (uMaxSides - 2);
+   int local = gl_VertexID % verticesPerShape;
+   uvec4 shape = texelFetch(uShapes, gl_VertexID / verticesPerShape);
+
+   vec2 center = vec2(ivec2(int(shape.x << 16u) >> 16, int(shape.x) >> 16)) / 32767.0 * 2.0;
+   vec2 radius = vec2(shape.y & 0xFFFFu, shape.y >> 16u) / 65535.0 * 2.0;
+   float rotation = float(shape.z & 0xFFFFu) / 65535.0 * 6.28318530718;
+   int sides = int((shape.z >> 16u) & 0xFFu);
+   color = vec4((uvec4(shape.w) >> uvec4(0u, 8u, 16u, 24u)) & 0xFFu) / 255.0;
+
+   // fan: triangle t is corners 0, t + 1, t + 2; the ones past sides - 2 collapse
+   int triangle = local / 3;
+   int corner = local % 3 == 0 ? 0 : triangle + local % 3;
+   if (triangle >= sides - 2)
+      corner = 0;
+
+   float angle = rotation + 1.57079632679 + 6.28318530718 * float(corner) / float(sides);
+   return placeShape(vec2(cos(angle), sin(angle)), center, radius);
+}
+#endif
+void main()
+{
+#if defined(PULLED)
+   gl_Position = pullShape(vColor);
+#elif defined(INSTANCED) && defined(INTERPOLATED)
+   gl_Position = placeShape(aPos, mix(aPreviousOffset, aOffset, uTime.w), aScale);
+   vColor = aColor;
+#elif defined(INSTANCED)
+   gl_Position = placeShape(aPos, aOffset, aScale);
+   vColor = aColor;
+#else
+   gl_Position = placeShape(aPos.xy, vec2(0.0), vec2(1.0));
+   gl_Position.z = aPos.z;
+#endif
+#ifdef PICK_ID
+#if defined(PULLED)
+   vId = uint(gl_VertexID / (3 * (uMaxSides - 2))) + 1u;
+#elif defined(INSTANCED)
+   vId = uint(gl_InstanceID) + 1u;
+#else
+   vId = 1u;
+#endif
+#endif
+#ifdef OBJECT_DATA
+   gl_Position.xy += uObjectOffset.xy;
+#endif
+#ifdef FRAME_DATA
+   gl_Position = uViewProjection * gl_Position;
+#endif
+}
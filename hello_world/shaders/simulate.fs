@@ -0,0 +1,5 @@
+#version 330 core
+// never runs, simulate.vs draws with GL_RASTERIZER_DISCARD
+void main()
+{
+}
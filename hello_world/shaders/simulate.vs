@@ -0,0 +1,22 @@
+#version 330 core
+// one shape per vertex, drawn as points with the rasterizer off; the new
+// state is captured by transform feedback. Keep in step with
+// GpuSimulation::stepReference.
+layout (location = 0) in vec2 aPosition;
+layout (location = 1) in vec2 aVelocity;
+uniform float uDelta;
+uniform vec4 uBounds;   // min x, min y, max x, max y
+out vec2 vPosition;
+out vec2 vVelocity;
+void main()
+{
+   vec2 position = aPosition + aVelocity * uDelta;
+   vec2 velocity = aVelocity;
+   // bounce off the walls
+   if (position.x < uBounds.x || position.x > uBounds.z)
+      velocity.x = -velocity.x;
+   if (position.y < uBounds.y || position.y > uBounds.w)
+      velocity.y = -velocity.y;
+   vPosition = clamp(position, uBounds.xy, uBounds.zw);
+   vVelocity = velocity;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "shader.cpp"
+
+// Watches the files of ProgramShaders loaded with loadFiles(), includes too,
+// and reloads a program when one of them is saved. The inotify reads happen
+// on a background thread which only records changed paths; poll() on the
+// render thread does the relinking, and ProgramShader::reload keeps the old
+// program on failure.
+//
+// Directories are watched rather than files, since editors often save by
+// writing a new file and renaming it over the old one.
+class ShaderWatcher {
+	private:
+		struct Watch {
+			int descriptor;
+			std::string directory;
+		};
+
+		int inotifyFd;
+		std::vector<Watch> watches;
+		std::vector<ProgramShader*> programs;
+		std::mutex mutex;
+		std::set<std::string> changed;
+		std::thread reader;
+		std::atomic<bool> stopping;
+
+		static std::string directoryOf(const std::string &path) {
+			size_t slash = path.find_last_of('/');
+			return slash == std::string::npos ? "." : path.substr(0, slash);
+		}
+
+		static std::string fileOf(const std::string &path) {
+			size_t slash = path.find_last_of('/');
+			return slash == std::string::npos ? path : path.substr(slash + 1);
+		}
+
+		void watchDirectory(const std::string &directory) {
+			for (unsigned int i = 0; i < watches.size(); i++) {
+				if (watches[i].directory == directory)
+					return;
+			}
+
+			int descriptor = inotify_add_watch(inotifyFd, directory.c_str(),
+					IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+			if (descriptor < 0) {
+				std::cout << "ERROR::SHADER::WATCH_FAILED " << directory << std::endl;
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			Watch watch = {descriptor, directory};
+			watches.push_back(watch);
+		}
+
+		void readLoop() {
+			char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+			while (!stopping) {
+				struct pollfd descriptor = {inotifyFd, POLLIN, 0};
+				if (::poll(&descriptor, 1, 100) <= 0)
+					continue;
+
+				ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+				if (length <= 0)
+					continue;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				for (char *ptr = buffer; ptr < buffer + length; ) {
+					struct inotify_event *event = (struct inotify_event*)ptr;
+					ptr += sizeof(struct inotify_event) + event->len;
+					if (event->len == 0)
+						continue;
+
+					for (unsigned int i = 0; i < watches.size(); i++) {
+						if (watches[i].descriptor == event->wd) {
+							changed.insert(watches[i].directory + "/" + event->name);
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		// the paths of program's files among paths, added to found
+		bool touches(ProgramShader *program, const std::set<std::string> &paths,
+				std::set<std::string> *found = NULL) {
+			bool touched = false;
+			const std::vector<std::string> &files = program->getDependencies();
+			for (unsigned int i = 0; i < files.size(); i++) {
+				std::string path = directoryOf(files[i]) + "/" + fileOf(files[i]);
+				if (paths.count(path)) {
+					touched = true;
+					if (found != NULL)
+						found->insert(path);
+				}
+			}
+			return touched;
+		}
+
+	public:
+		ShaderWatcher () {
+			stopping = false;
+			inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (inotifyFd < 0) {
+				std::cout << "ERROR::SHADER::INOTIFY_UNAVAILABLE" << std::endl;
+				return;
+			}
+			reader = std::thread(&ShaderWatcher::readLoop, this);
+		}
+
+		~ShaderWatcher () {
+			stopping = true;
+			if (reader.joinable())
+				reader.join();
+			if (inotifyFd >= 0)
+				close(inotifyFd);
+		}
+
+		void watch(ProgramShader *program) {
+			if (inotifyFd < 0 || program->getVertexPath().empty())
+				return;
+
+			programs.push_back(program);
+			const std::vector<std::string> &files = program->getDependencies();
+			for (unsigned int i = 0; i < files.size(); i++)
+				watchDirectory(directoryOf(files[i]));
+		}
+
+		// render thread, once per frame: relinks programs whose files changed
+		// and returns how many were swapped in. A program still compiling
+		// keeps its changes queued until it is ready
+		int poll() {
+			std::set<std::string> paths;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (changed.empty())
+					return 0;
+				paths.swap(changed);
+			}
+
+			int reloaded = 0;
+			std::set<std::string> retry;
+			for (unsigned int i = 0; i < programs.size(); i++) {
+				if (!programs[i]->isReady()) {
+					touches(programs[i], paths, &retry);
+					continue;
+				}
+				if (!touches(programs[i], paths))
+					continue;
+
+				if (programs[i]->reload()) {
+					std::cout << "reloaded " << programs[i]->getVertexPath() << " + "
+						<< programs[i]->getFragmentPath() << std::endl;
+					reloaded++;
+				}
+			}
+
+			if (!retry.empty()) {
+				std::lock_guard<std::mutex> lock(mutex);
+				changed.insert(retry.begin(), retry.end());
+			}
+			return reloaded;
+		}
+};
@@ -0,0 +1,86 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "simulation.cpp"
+
+//./simbench <shapes> <steps>
+//moves the same shapes on the cpu (GpuSimulation::stepReference) and on the
+//gpu, times both and compares the results. Without a gpu:
+//  LIBGL_ALWAYS_SOFTWARE=1 ./simbench 100000 100
+int main(int argc, char** argv) {
+	int count = argc > 1 ? atoi(argv[1]) : 100000;
+	int steps = argc > 2 ? atoi(argv[2]) : 100;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	GLFWwindow* window = glfwCreateWindow(64, 64, "simbench", NULL, NULL);
+	if (window == NULL){
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		return -1;
+	}
+
+	srand(1);
+	std::vector<ShapeState> states(count);
+	for (int i = 0; i < count; i++) {
+		states[i].position[0] = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+		states[i].position[1] = rand() / (float)RAND_MAX * 2.0f - 1.0f;
+		states[i].velocity[0] = rand() / (float)RAND_MAX - 0.5f;
+		states[i].velocity[1] = rand() / (float)RAND_MAX - 0.5f;
+	}
+	const float bounds[4] = {-1.0f, -1.0f, 1.0f, 1.0f};
+	const float delta = 1.0f / 60.0f;
+
+	GpuSimulation simulation(states);
+	if (!simulation.getProgram().isLinked()) {
+		std::cout << "simulate shader did not link" << std::endl;
+		return -1;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < steps; i++)
+		GpuSimulation::stepReference(states, delta, bounds);
+	double cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	//one warm up step outside the timing, then compare from the start again
+	std::vector<ShapeState> gpuStates;
+	simulation.step(0.0f, bounds);
+	glFinish();
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < steps; i++)
+		simulation.step(delta, bounds);
+	glFinish();
+	double gpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	simulation.read(gpuStates);
+
+	float maxError = 0.0f;
+	for (int i = 0; i < count; i++) {
+		for (int axis = 0; axis < 2; axis++)
+			maxError = fmaxf(maxError, fabsf(gpuStates[i].position[axis] - states[i].position[axis]));
+	}
+
+	std::cout << count << " shapes, " << steps << " steps" << std::endl;
+	std::cout << "cpu: " << cpuMs << " ms, " << cpuMs / steps << " ms a step" << std::endl;
+	std::cout << "gpu: " << gpuMs << " ms, " << gpuMs / steps << " ms a step (with glFinish)" << std::endl;
+	std::cout << "max position difference: " << maxError << std::endl;
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+
+#include "statecache.cpp"
+#include "shader.cpp"
+#include "vertexformat.cpp"
+
+// Position and velocity of one moving shape, as simulate.vs reads and
+// writes it.
+struct ShapeState {
+	float position[2];
+	float velocity[2];
+};
+
+typedef VertexFormat<Float2, Float2> ShapeStateFormat;
+static_assert(ShapeStateFormat::stride == sizeof(ShapeState), "ShapeStateFormat must match ShapeState");
+
+// Moves shapes on the gpu with transform feedback: each step draws the
+// current state buffer as points through simulate.vs with the rasterizer
+// off and captures the new state into the other buffer, then the two swap.
+// Nothing comes back to the cpu; getBuffer() is fed straight into the
+// instanced draw as per-instance offsets (InstancedRenderer::drawFed).
+//
+// GL 3.3 has no transform feedback objects, the capture buffer is bound
+// with glBindBufferBase for every step.
+class GpuSimulation {
+	private:
+		ProgramShader program;
+		unsigned int buffers[2];
+		unsigned int vertexArrays[2];
+		int current;
+		unsigned int count;
+		int deltaHandle;
+		int boundsHandle;
+		unsigned int generation;
+
+	public:
+		GpuSimulation (const std::vector<ShapeState> &initial) {
+			count = initial.size();
+			current = 0;
+
+			std::vector<std::string> varyings;
+			varyings.push_back("vPosition");
+			varyings.push_back("vVelocity");
+			program.loadFiles("shaders/simulate.vs", "shaders/simulate.fs");
+			program.setFeedbackVaryings(varyings);
+			program.createShaders();
+			program.createShaderProgram();
+			generation = program.getGeneration();
+			deltaHandle = program.uniformHandle("uDelta");
+			boundsHandle = program.uniformHandle("uBounds");
+
+			glGenBuffers(2, buffers);
+			glGenVertexArrays(2, vertexArrays);
+			for (int i = 0; i < 2; i++) {
+				glState.bindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+				glBufferData(GL_ARRAY_BUFFER, count * sizeof(ShapeState), initial.data(), GL_DYNAMIC_COPY);
+				glState.bindVertexArray(vertexArrays[i]);
+				ShapeStateFormat::setup(buffers[i]);
+			}
+		}
+
+		// bounds: min x, min y, max x, max y
+		void step(float delta, const float (&bounds)[4]) {
+			if (count == 0 || !program.isLinked())
+				return;
+
+			if (generation != program.getGeneration()) {
+				deltaHandle = program.uniformHandle("uDelta");
+				boundsHandle = program.uniformHandle("uBounds");
+				generation = program.getGeneration();
+			}
+
+			program.setUniform(deltaHandle, delta);
+			program.setUniform(boundsHandle, bounds);
+			glState.useProgram(program.getProgram());
+			glState.bindVertexArray(vertexArrays[current]);
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffers[1 - current]);
+
+			glEnable(GL_RASTERIZER_DISCARD);
+			glBeginTransformFeedback(GL_POINTS);
+			glDrawArrays(GL_POINTS, 0, count);
+			glEndTransformFeedback();
+			glDisable(GL_RASTERIZER_DISCARD);
+
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+			current = 1 - current;
+		}
+
+		// overwrites one shape in the latest and the previous state, so
+		// blending between the two does not slide it to its new place
+		void set(int index, const ShapeState &state) {
+			for (int i = 0; i < 2; i++) {
+				glState.bindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+				glBufferSubData(GL_ARRAY_BUFFER, index * sizeof(ShapeState), sizeof(ShapeState), &state);
+			}
+		}
+
+		// blocks until the gpu is done, for checks and benchmarks only
+		void read(std::vector<ShapeState> &states) {
+			states.resize(count);
+			glState.bindBuffer(GL_ARRAY_BUFFER, buffers[current]);
+			glGetBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(ShapeState), states.data());
+		}
+
+		// holds the latest state, positions first in every ShapeState
+		unsigned int getBuffer() {
+			return buffers[current];
+		}
+
+		// the state one step before getBuffer(), the same before the first step
+		unsigned int getPreviousBuffer() {
+			return buffers[1 - current];
+		}
+
+		unsigned int size() {
+			return count;
+		}
+
+		ProgramShader &getProgram() {
+			return program;
+		}
+
+		// the same step on the cpu, operation for operation as simulate.vs
+		static void stepReference(std::vector<ShapeState> &states, float delta, const float (&bounds)[4]) {
+			for (unsigned int i = 0; i < states.size(); i++) {
+				ShapeState &state = states[i];
+				for (int axis = 0; axis < 2; axis++) {
+					float position = state.position[axis] + state.velocity[axis] * delta;
+					if (position < bounds[axis] || position > bounds[axis + 2])
+						state.velocity[axis] = -state.velocity[axis];
+					position = position < bounds[axis] ? bounds[axis] : position;
+					position = position > bounds[axis + 2] ? bounds[axis + 2] : position;
+					state.position[axis] = position;
+				}
+			}
+		}
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+struct StateCounters {
+	unsigned int issued;
+	unsigned int elided;
+	unsigned int uniformsUploaded;
+	unsigned int uniformsSkipped;
+};
+
+// Remembers the bindings and fixed state we last set and skips calls that
+// would not change anything. Everything that binds a program, VAO or buffer
+// must go through glState, otherwise the cache goes stale; call invalidate()
+// after code that talks to GL directly.
+class GLStateCache {
+	private:
+		static const unsigned int unknown = 0xFFFFFFFF;
+		static const int maxTargets = 8;
+		static const int maxUniformBindings = 8;
+
+		unsigned int program;
+		unsigned int vertexArray;
+		unsigned int framebuffer;
+		GLenum targets[maxTargets];
+		unsigned int buffers[maxTargets];
+		unsigned int rangeBuffers[maxUniformBindings];
+		int rangeOffsets[maxUniformBindings];
+		int rangeSizes[maxUniformBindings];
+		int viewportRect[4];
+		float clearRGBA[4];
+		bool viewportKnown;
+		bool clearKnown;
+		StateCounters frameCounters;
+		StateCounters totalCounters;
+
+		bool changed(bool isNew) {
+			if (isNew)
+				frameCounters.issued++;
+			else
+				frameCounters.elided++;
+			return isNew;
+		}
+
+		int targetSlot(GLenum target) {
+			for (int i = 0; i < maxTargets; i++) {
+				if (targets[i] == target || targets[i] == 0) {
+					targets[i] = target;
+					return i;
+				}
+			}
+			return -1;
+		}
+
+	public:
+		GLStateCache () {
+			for (int i = 0; i < maxTargets; i++)
+				targets[i] = 0;
+			invalidate();
+			frameCounters = StateCounters();
+			totalCounters = StateCounters();
+		}
+
+		void invalidate() {
+			program = unknown;
+			vertexArray = unknown;
+			framebuffer = unknown;
+			for (int i = 0; i < maxTargets; i++)
+				buffers[i] = unknown;
+			for (int i = 0; i < maxUniformBindings; i++)
+				rangeBuffers[i] = unknown;
+			viewportKnown = false;
+			clearKnown = false;
+		}
+
+		void useProgram(unsigned int id) {
+			if (changed(id != program)) {
+				glUseProgram(id);
+				program = id;
+			}
+		}
+
+		void bindVertexArray(unsigned int id) {
+			if (changed(id != vertexArray)) {
+				glBindVertexArray(id);
+				vertexArray = id;
+				//the element buffer binding belongs to the VAO
+				buffers[targetSlot(GL_ELEMENT_ARRAY_BUFFER)] = unknown;
+			}
+		}
+
+		// draw and read framebuffer together, 0 is the window
+		void bindFramebuffer(unsigned int id) {
+			if (changed(id != framebuffer)) {
+				glBindFramebuffer(GL_FRAMEBUFFER, id);
+				framebuffer = id;
+			}
+		}
+
+		void bindBuffer(GLenum target, unsigned int id) {
+			int slot = targetSlot(target);
+			if (slot < 0) {
+				frameCounters.issued++;
+				glBindBuffer(target, id);
+				return;
+			}
+
+			if (changed(id != buffers[slot])) {
+				glBindBuffer(target, id);
+				buffers[slot] = id;
+			}
+		}
+
+		// indexed uniform buffer bindings; also moves the generic binding
+		void bindBufferRange(GLenum target, unsigned int index, unsigned int id, int offset, int size) {
+			if (target != GL_UNIFORM_BUFFER || index >= (unsigned int)maxUniformBindings) {
+				frameCounters.issued++;
+				glBindBufferRange(target, index, id, offset, size);
+				buffers[targetSlot(target)] = unknown;
+				return;
+			}
+
+			bool same = rangeBuffers[index] == id && rangeOffsets[index] == offset
+				&& rangeSizes[index] == size;
+			if (changed(!same)) {
+				glBindBufferRange(target, index, id, offset, size);
+				rangeBuffers[index] = id;
+				rangeOffsets[index] = offset;
+				rangeSizes[index] = size;
+				buffers[targetSlot(target)] = id;
+			}
+		}
+
+		void viewport(int x, int y, int width, int height) {
+			bool same = viewportKnown && viewportRect[0] == x && viewportRect[1] == y
+				&& viewportRect[2] == width && viewportRect[3] == height;
+			if (changed(!same)) {
+				glViewport(x, y, width, height);
+				viewportRect[0] = x;
+				viewportRect[1] = y;
+				viewportRect[2] = width;
+				viewportRect[3] = height;
+				viewportKnown = true;
+			}
+		}
+
+		void clearColor(float r, float g, float b, float a) {
+			bool same = clearKnown && clearRGBA[0] == r && clearRGBA[1] == g
+				&& clearRGBA[2] == b && clearRGBA[3] == a;
+			if (changed(!same)) {
+				glClearColor(r, g, b, a);
+				clearRGBA[0] = r;
+				clearRGBA[1] = g;
+				clearRGBA[2] = b;
+				clearRGBA[3] = a;
+				clearKnown = true;
+			}
+		}
+
+		// counts a uniform set, see UniformTable; the caller does the upload
+		bool uniformChanged(bool isNew) {
+			if (isNew)
+				frameCounters.uniformsUploaded++;
+			else
+				frameCounters.uniformsSkipped++;
+			return isNew;
+		}
+
+		unsigned int currentProgram() {
+			return program;
+		}
+
+		// call once per frame, returns the counters of the frame that ended
+		StateCounters endFrame() {
+			StateCounters last = frameCounters;
+			totalCounters.issued += last.issued;
+			totalCounters.elided += last.elided;
+			totalCounters.uniformsUploaded += last.uniformsUploaded;
+			totalCounters.uniformsSkipped += last.uniformsSkipped;
+			frameCounters = StateCounters();
+			return last;
+		}
+
+		const StateCounters &getFrameCounters() {
+			return frameCounters;
+		}
+
+		const StateCounters &getTotalCounters() {
+			return totalCounters;
+		}
+};
+
+static GLStateCache glState;
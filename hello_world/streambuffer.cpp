@@ -0,0 +1,172 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+
+#include "statecache.cpp"
+
+struct StreamStats {
+	unsigned long long bytesStreamed;
+	unsigned int writes;
+	unsigned int stallsAvoided;  //region was already free when the frame began
+	unsigned int stalls;         //had to wait for the gpu to release the region
+	unsigned int orphans;        //frame overflowed its region, whole buffer reallocated
+};
+
+// Ring of per-frame regions carved out of one large buffer. Each frame writes
+// into its own region through unsynchronized mapped ranges, and a fence placed
+// at the end of the frame tells us when the gpu is done reading it, so a
+// region is only reused once its frame has been consumed.
+//
+//   stream.beginFrame();
+//   int offset = stream.write(data, bytes, alignment);
+//   ... draws reading [offset, offset + bytes) ...
+//   stream.endFrame();
+class StreamBuffer {
+	private:
+		static const int maxRegions = 8;
+
+		unsigned int buffer;
+		GLenum target;
+		unsigned int regionSize;
+		int regionCount;
+		int currentRegion;
+		unsigned int head;
+		GLsync fences[maxRegions];
+		StreamStats frameStats;
+		StreamStats totalStats;
+		unsigned int frames;
+
+		void addStats(StreamStats &to, const StreamStats &from) {
+			to.bytesStreamed += from.bytesStreamed;
+			to.writes += from.writes;
+			to.stallsAvoided += from.stallsAvoided;
+			to.stalls += from.stalls;
+			to.orphans += from.orphans;
+		}
+
+	public:
+		StreamBuffer (GLenum bufferTarget, unsigned int bytesPerFrame, int frameCount = 3) {
+			target = bufferTarget;
+			regionSize = bytesPerFrame;
+			regionCount = frameCount < maxRegions ? frameCount : maxRegions;
+			currentRegion = 0;
+			head = 0;
+			frames = 0;
+			memset(fences, 0, sizeof(fences));
+			memset(&frameStats, 0, sizeof(frameStats));
+			memset(&totalStats, 0, sizeof(totalStats));
+
+			glGenBuffers(1, &buffer);
+			glState.bindBuffer(target, buffer);
+			glBufferData(target, regionSize * regionCount, NULL, GL_STREAM_DRAW);
+		}
+
+		void beginFrame() {
+			addStats(totalStats, frameStats);
+			memset(&frameStats, 0, sizeof(frameStats));
+
+			currentRegion = (currentRegion + 1) % regionCount;
+			head = 0;
+			frames++;
+
+			GLsync fence = fences[currentRegion];
+			if (fence == 0)
+				return;
+
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+				frameStats.stallsAvoided++;
+			} else {
+				frameStats.stalls++;
+				while (result == GL_TIMEOUT_EXPIRED)
+					result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			}
+			glDeleteSync(fence);
+			fences[currentRegion] = 0;
+		}
+
+		void endFrame() {
+			fences[currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		// maps bytes of the current region for writing, offset receives the
+		// position in the buffer. Call unmap() and issue the draws reading it
+		// before the next map, an overflow orphans the storage behind it.
+		void *map(unsigned int bytes, unsigned int alignment, unsigned int &offset) {
+			if (bytes > regionSize)
+				return NULL;
+
+			unsigned int base = currentRegion * regionSize;
+			unsigned int start = (base + head + alignment - 1) / alignment * alignment;
+			glState.bindBuffer(target, buffer);
+
+			if (start + bytes > base + regionSize) {
+				//frame used more than its share: hand the old storage to the
+				//driver and start over, every region in flight stays valid
+				glBufferData(target, regionSize * regionCount, NULL, GL_STREAM_DRAW);
+				for (int i = 0; i < regionCount; i++) {
+					if (fences[i] != 0)
+						glDeleteSync(fences[i]);
+					fences[i] = 0;
+				}
+				frameStats.orphans++;
+				head = 0;
+				start = (base + alignment - 1) / alignment * alignment;
+				if (start + bytes > base + regionSize)
+					return NULL;
+			}
+
+			void *ptr = glMapBufferRange(target, start, bytes,
+					GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			if (ptr == NULL)
+				return NULL;
+
+			head = start + bytes - base;
+			offset = start;
+			frameStats.bytesStreamed += bytes;
+			frameStats.writes++;
+			return ptr;
+		}
+
+		void unmap() {
+			glState.bindBuffer(target, buffer);
+			glUnmapBuffer(target);
+		}
+
+		// copies data into the current region, returns its offset or -1
+		int write(const void *data, unsigned int bytes, unsigned int alignment = 4) {
+			unsigned int offset;
+			void *ptr = map(bytes, alignment, offset);
+			if (ptr == NULL)
+				return -1;
+
+			memcpy(ptr, data, bytes);
+			unmap();
+			return offset;
+		}
+
+		unsigned int getBuffer() {
+			return buffer;
+		}
+
+		unsigned int getRegionSize() {
+			return regionSize;
+		}
+
+		const StreamStats &getFrameStats() {
+			return frameStats;
+		}
+
+		StreamStats getTotalStats() {
+			StreamStats total = totalStats;
+			addStats(total, frameStats);
+			return total;
+		}
+
+		unsigned int getFrames() {
+			return frames;
+		}
+};
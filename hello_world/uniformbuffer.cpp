@@ -0,0 +1,232 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "statecache.cpp"
+#include "streambuffer.cpp"
+#include "uniformtable.cpp"
+
+// Fills a uniform block with the std140 rules, in the order the members are
+// declared in GLSL:
+//   float, int     4 byte aligned
+//   vec2           8 byte aligned
+//   vec3, vec4     16 byte aligned (a vec3 still leaves room for a float after it)
+//   mat4           four vec4 columns
+//   arrays         every element on 16 bytes, even floats
+class Std140Writer {
+	private:
+		std::vector<unsigned char> bytes;
+
+		void put(const void *value, unsigned int size, unsigned int alignment) {
+			align(alignment);
+			unsigned int offset = bytes.size();
+			bytes.resize(offset + size);
+			memcpy(&bytes[offset], value, size);
+		}
+
+	public:
+		void clear() {
+			bytes.clear();
+		}
+
+		void align(unsigned int alignment) {
+			bytes.resize((bytes.size() + alignment - 1) / alignment * alignment, 0);
+		}
+
+		void writeFloat(float value) {
+			put(&value, 4, 4);
+		}
+
+		void writeInt(int value) {
+			put(&value, 4, 4);
+		}
+
+		void writeVec2(const float value[2]) {
+			put(value, 8, 8);
+		}
+
+		void writeVec3(const float value[3]) {
+			put(value, 12, 16);
+		}
+
+		void writeVec4(const float value[4]) {
+			put(value, 16, 16);
+		}
+
+		// column major, as glUniformMatrix4fv with transpose false
+		void writeMat4(const float value[16]) {
+			for (int column = 0; column < 4; column++)
+				put(value + column * 4, 16, 16);
+		}
+
+		void writeFloatArray(const float *values, int count) {
+			for (int i = 0; i < count; i++)
+				put(values + i, 4, 16);
+			align(16);
+		}
+
+		// block size as GL sees it, rounded up to a vec4
+		unsigned int size() {
+			align(16);
+			return bytes.size();
+		}
+
+		const unsigned char *data() {
+			return bytes.data();
+		}
+};
+
+// Mirrors shaders/frame.glsl, keep the two in the same order.
+struct FrameData {
+	float viewProjection[16];
+	float time;
+	float delta;
+	unsigned int frame;
+	float interpolation;     //between the last two simulation ticks, 0..1
+
+	//what write() produces: a mat4 and a vec4
+	static const unsigned int blockSize = 80;
+
+	void write(Std140Writer &block) const {
+		float timeInfo[4] = {time, delta, (float)frame, interpolation};
+		block.clear();
+		block.writeMat4(viewProjection);
+		block.writeVec4(timeInfo);
+	}
+
+	// identity, clip space is the world for now
+	static FrameData at(float time, float delta, unsigned int frame, float interpolation = 0.0f) {
+		FrameData data;
+		for (int i = 0; i < 16; i++)
+			data.viewProjection[i] = i % 5 == 0 ? 1.0f : 0.0f;
+		data.time = time;
+		data.delta = delta;
+		data.frame = frame;
+		data.interpolation = interpolation;
+		return data;
+	}
+};
+
+// Per-frame uniform blocks in a StreamBuffer ring. One FrameData block a frame
+// is bound at FrameDataBinding for every program at once; any number of
+// ObjectData blocks are packed behind it and selected per draw with
+// glBindBufferRange at ObjectDataBinding. Blocks are gathered on the cpu and
+// reach the buffer in a single write.
+//
+//   ring.beginFrame();
+//   ring.setFrame(frameBlock);
+//   int block = ring.pushObject(objectBlock);   //as often as needed
+//   ring.upload();                              //binds the frame block
+//   ring.bindObject(block); draw...
+//   ring.endFrame();
+// The frame block's slot is kept free whichever comes first; a frame block
+// set after objects must fit the FrameData sized slot.
+class UniformRing {
+	private:
+		StreamBuffer stream;
+		unsigned int alignment;
+		std::vector<unsigned char> staging;
+		std::vector<unsigned int> objectOffsets;
+		std::vector<unsigned int> objectSizes;
+		unsigned int frameSize;
+		unsigned int frameSlot;
+		int base;
+
+		//room for a FrameData block in front of the objects
+		void reserveFrame() {
+			if (staging.empty())
+				staging.resize(frameSlot, 0);
+		}
+
+		unsigned int append(Std140Writer &block) {
+			unsigned int offset = (staging.size() + alignment - 1) / alignment * alignment;
+			unsigned int size = block.size();
+			staging.resize(offset + size, 0);
+			memcpy(&staging[offset], block.data(), size);
+			return offset;
+		}
+
+		static unsigned int offsetAlignment() {
+			int value = 256;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &value);
+			return value > 0 ? value : 256;
+		}
+
+	public:
+		UniformRing (unsigned int bytesPerFrame, int frameCount = 3)
+			: stream(GL_UNIFORM_BUFFER, bytesPerFrame, frameCount) {
+			alignment = offsetAlignment();
+			frameSlot = (FrameData::blockSize + alignment - 1) / alignment * alignment;
+			frameSize = 0;
+			base = -1;
+		}
+
+		void beginFrame() {
+			stream.beginFrame();
+			staging.clear();
+			objectOffsets.clear();
+			objectSizes.clear();
+			frameSize = 0;
+			base = -1;
+		}
+
+		// the frame block always sits at the start of the frame's data
+		void setFrame(Std140Writer &block) {
+			reserveFrame();
+			unsigned int size = block.size();
+			if (size > frameSlot && !objectOffsets.empty()) {
+				std::cout << "ERROR::UNIFORMRING::FRAME_BLOCK_TOO_LARGE " << size << " bytes after objects" << std::endl;
+				return;
+			}
+			frameSize = size;
+			if (frameSize > staging.size())
+				staging.resize((frameSize + alignment - 1) / alignment * alignment, 0);
+			memcpy(&staging[0], block.data(), frameSize);
+		}
+
+		// returns the block's index for bindObject()
+		int pushObject(Std140Writer &block) {
+			reserveFrame();
+			objectOffsets.push_back(append(block));
+			objectSizes.push_back(block.size());
+			return objectOffsets.size() - 1;
+		}
+
+		// writes every block of the frame, false when they did not fit
+		bool upload() {
+			if (staging.empty())
+				return true;
+
+			base = stream.write(staging.data(), staging.size(), alignment);
+			if (base < 0)
+				return false;
+
+			if (frameSize > 0)
+				glState.bindBufferRange(GL_UNIFORM_BUFFER, FrameDataBinding, stream.getBuffer(), base, frameSize);
+			return true;
+		}
+
+		void bindObject(int block) {
+			if (base < 0 || block < 0)
+				return;
+			glState.bindBufferRange(GL_UNIFORM_BUFFER, ObjectDataBinding, stream.getBuffer(),
+					base + objectOffsets[block], objectSizes[block]);
+		}
+
+		void endFrame() {
+			stream.endFrame();
+		}
+
+		unsigned int objectCount() {
+			return objectOffsets.size();
+		}
+
+		StreamStats getTotalStats() {
+			return stream.getTotalStats();
+		}
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "statecache.cpp"
+
+// Uniform block binding points shared by every program, see UniformRing.
+// Blocks with these names are bound to them right after link.
+enum UniformBlockBinding {
+	FrameDataBinding = 0,
+	ObjectDataBinding = 1
+};
+
+// C++ type -> GLSL type and the glUniform call for it. Only these can be
+// passed to UniformTable::set, anything else does not compile.
+template<typename T> struct UniformType;
+
+template<> struct UniformType<float> {
+	static const GLenum type = GL_FLOAT;
+	static void upload(int location, const float &value) { glUniform1f(location, value); }
+};
+template<> struct UniformType<int> {
+	static const GLenum type = GL_INT;
+	static void upload(int location, const int &value) { glUniform1i(location, value); }
+};
+template<> struct UniformType<unsigned int> {
+	static const GLenum type = GL_UNSIGNED_INT;
+	static void upload(int location, const unsigned int &value) { glUniform1ui(location, value); }
+};
+template<> struct UniformType<float[2]> {
+	static const GLenum type = GL_FLOAT_VEC2;
+	static void upload(int location, const float (&value)[2]) { glUniform2fv(location, 1, value); }
+};
+template<> struct UniformType<float[3]> {
+	static const GLenum type = GL_FLOAT_VEC3;
+	static void upload(int location, const float (&value)[3]) { glUniform3fv(location, 1, value); }
+};
+template<> struct UniformType<float[4]> {
+	static const GLenum type = GL_FLOAT_VEC4;
+	static void upload(int location, const float (&value)[4]) { glUniform4fv(location, 1, value); }
+};
+template<> struct UniformType<int[2]> {
+	static const GLenum type = GL_INT_VEC2;
+	static void upload(int location, const int (&value)[2]) { glUniform2iv(location, 1, value); }
+};
+template<> struct UniformType<float[9]> {
+	static const GLenum type = GL_FLOAT_MAT3;
+	static void upload(int location, const float (&value)[9]) { glUniformMatrix3fv(location, 1, GL_FALSE, value); }
+};
+template<> struct UniformType<float[16]> {
+	static const GLenum type = GL_FLOAT_MAT4;
+	static void upload(int location, const float (&value)[16]) { glUniformMatrix4fv(location, 1, GL_FALSE, value); }
+};
+
+// Active uniforms and attributes of a linked program, read once after link.
+// Look a uniform up by name once, keep the handle (an index into the table)
+// and set it through the handle in the loop: no string lookups, and a value
+// equal to the one already in the program is not uploaded again.
+class UniformTable {
+	private:
+		static const int maxValueBytes = 64;
+
+		struct Uniform {
+			std::string name;
+			GLenum type;
+			int size;
+			int location;
+			bool known;
+			unsigned char value[maxValueBytes];
+		};
+
+		struct Attribute {
+			std::string name;
+			GLenum type;
+			int size;
+			int location;
+		};
+
+		unsigned int program;
+		std::vector<Uniform> uniforms;
+		std::vector<Attribute> attributes;
+
+		//arrays are reported as "name[0]", they are found by their plain name too
+		static std::string baseName(const char *name) {
+			std::string base = name;
+			size_t bracket = base.find('[');
+			return bracket == std::string::npos ? base : base.substr(0, bracket);
+		}
+
+		static bool isSampler(GLenum type) {
+			return type == GL_SAMPLER_1D || type == GL_SAMPLER_2D || type == GL_SAMPLER_3D
+				|| type == GL_SAMPLER_CUBE || type == GL_SAMPLER_BUFFER
+				|| type == GL_INT_SAMPLER_BUFFER || type == GL_UNSIGNED_INT_SAMPLER_BUFFER
+				|| type == GL_UNSIGNED_INT_SAMPLER_2D || type == GL_SAMPLER_2D_ARRAY;
+		}
+
+		void bindBlock(const char *name, unsigned int binding) {
+			unsigned int index = glGetUniformBlockIndex(program, name);
+			if (index != GL_INVALID_INDEX)
+				glUniformBlockBinding(program, index, binding);
+		}
+
+	public:
+		UniformTable () {
+			program = 0;
+		}
+
+		// may run on a context sharing objects with the render one
+		void reflect(unsigned int linkedProgram) {
+			program = linkedProgram;
+			uniforms.clear();
+			attributes.clear();
+
+			int count = 0, maxLength = 0;
+			glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+			glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+			std::vector<char> name(maxLength > 0 ? maxLength : 1);
+			for (int i = 0; i < count; i++) {
+				Uniform uniform;
+				glGetActiveUniform(program, i, name.size(), NULL, &uniform.size, &uniform.type, &name[0]);
+				uniform.name = baseName(&name[0]);
+				uniform.location = glGetUniformLocation(program, &name[0]);
+				uniform.known = false;
+				//uniforms inside blocks have no location and are not set one by one
+				if (uniform.location >= 0)
+					uniforms.push_back(uniform);
+			}
+
+			bindBlock("FrameData", FrameDataBinding);
+			bindBlock("ObjectData", ObjectDataBinding);
+
+			glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+			glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+			name.assign(maxLength > 0 ? maxLength : 1, '\0');
+			for (int i = 0; i < count; i++) {
+				Attribute attribute;
+				glGetActiveAttrib(program, i, name.size(), NULL, &attribute.size, &attribute.type, &name[0]);
+				attribute.name = &name[0];
+				attribute.location = glGetAttribLocation(program, &name[0]);
+				attributes.push_back(attribute);
+			}
+		}
+
+		// -1 when the program has no such active uniform, setting -1 is a no-op
+		int handle(const char *name) {
+			for (unsigned int i = 0; i < uniforms.size(); i++) {
+				if (uniforms[i].name == name)
+					return i;
+			}
+			return -1;
+		}
+
+		int location(int handle) {
+			return handle < 0 ? -1 : uniforms[handle].location;
+		}
+
+		int attributeLocation(const char *name) {
+			for (unsigned int i = 0; i < attributes.size(); i++) {
+				if (attributes[i].name == name)
+					return attributes[i].location;
+			}
+			return -1;
+		}
+
+		// uses the program through glState, uploads only a changed value
+		template<typename T>
+		void set(int handle, const T &value) {
+			if (handle < 0)
+				return;
+
+			Uniform &uniform = uniforms[handle];
+			bool samplerUnit = UniformType<T>::type == GL_INT && isSampler(uniform.type);
+			if (uniform.type != UniformType<T>::type && !samplerUnit) {
+				std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH " << uniform.name << std::endl;
+				return;
+			}
+
+			static_assert(sizeof(T) <= maxValueBytes, "uniform value too large to cache");
+			if (!glState.uniformChanged(!uniform.known || memcmp(uniform.value, &value, sizeof(T)) != 0))
+				return;
+
+			glState.useProgram(program);
+			UniformType<T>::upload(uniform.location, value);
+			memcpy(uniform.value, &value, sizeof(T));
+			uniform.known = true;
+		}
+
+		unsigned int uniformCount() {
+			return uniforms.size();
+		}
+
+		unsigned int attributeCount() {
+			return attributes.size();
+		}
+
+		const std::string &uniformName(int handle) {
+			return uniforms[handle].name;
+		}
+};
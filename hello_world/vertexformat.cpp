@@ -0,0 +1,169 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "statecache.cpp"
+
+// One vertex attribute: GL component type, component count, bytes per
+// component, and how the shader sees it (normalized to [0,1]/[-1,1], plain
+// float conversion, or an integer through glVertexAttribIPointer).
+template<GLenum Type, int Components, int ComponentBytes, bool Normalized, bool Integer = false>
+struct VertexAttribute {
+	static const unsigned int size = Components * ComponentBytes;
+
+	static void point(unsigned int location, unsigned int stride, uintptr_t offset) {
+		if (Integer)
+			glVertexAttribIPointer(location, Components, Type, stride, (void*)offset);
+		else
+			glVertexAttribPointer(location, Components, Type, Normalized ? GL_TRUE : GL_FALSE,
+					stride, (void*)offset);
+	}
+};
+
+typedef VertexAttribute<GL_FLOAT, 1, 4, false> Float1;
+typedef VertexAttribute<GL_FLOAT, 2, 4, false> Float2;
+typedef VertexAttribute<GL_FLOAT, 3, 4, false> Float3;
+typedef VertexAttribute<GL_FLOAT, 4, 4, false> Float4;
+typedef VertexAttribute<GL_HALF_FLOAT, 2, 2, false> Half2;
+typedef VertexAttribute<GL_HALF_FLOAT, 4, 2, false> Half4;
+typedef VertexAttribute<GL_UNSIGNED_BYTE, 4, 1, true> UByte4Norm;   //RGBA8 colors
+typedef VertexAttribute<GL_SHORT, 2, 2, true> Short2Norm;           //int16 quantized [-1,1]
+typedef VertexAttribute<GL_SHORT, 4, 2, true> Short4Norm;
+typedef VertexAttribute<GL_UNSIGNED_INT, 1, 4, false, true> UInt1;
+
+// Interleaved attributes of one buffer, at consecutive locations. Stride and
+// offsets are compile-time constants:
+//
+//   typedef VertexFormat<Short2Norm, UByte4Norm> ColoredVertex;   //8 bytes
+//   ColoredVertex::setup(vbo);         //locations 0 and 1
+//   ColoredVertex::offset(1) == 4
+template<typename... Attributes>
+struct VertexFormat;
+
+template<>
+struct VertexFormat<> {
+	static const unsigned int stride = 0;
+	static const unsigned int count = 0;
+
+	static constexpr unsigned int offset(int) {
+		return 0;
+	}
+
+	static void pointAll(unsigned int, unsigned int, uintptr_t) {
+	}
+
+	static void enableAll(unsigned int, unsigned int) {
+	}
+};
+
+template<typename First, typename... Rest>
+struct VertexFormat<First, Rest...> {
+	typedef VertexFormat<Rest...> Tail;
+
+	static const unsigned int stride = First::size + Tail::stride;
+	static const unsigned int count = 1 + Tail::count;
+
+	static constexpr unsigned int offset(int index) {
+		return index == 0 ? 0 : First::size + Tail::offset(index - 1);
+	}
+
+	static void pointAll(unsigned int location, unsigned int vertexStride, uintptr_t base) {
+		First::point(location, vertexStride, base);
+		Tail::pointAll(location + 1, vertexStride, base + First::size);
+	}
+
+	static void enableAll(unsigned int location, unsigned int divisor) {
+		glEnableVertexAttribArray(location);
+		if (divisor != 0)
+			glVertexAttribDivisor(location, divisor);
+		Tail::enableAll(location + 1, divisor);
+	}
+
+	// attribute pointers into the bound GL_ARRAY_BUFFER, starting at byte base
+	static void point(unsigned int firstLocation = 0, uintptr_t base = 0) {
+		pointAll(firstLocation, stride, base);
+	}
+
+	// binds buffer and sets up the bound VAO; divisor 1 for per-instance data
+	static void setup(unsigned int buffer, unsigned int firstLocation = 0, unsigned int divisor = 0) {
+		glState.bindBuffer(GL_ARRAY_BUFFER, buffer);
+		point(firstLocation);
+		enableAll(firstLocation, divisor);
+	}
+};
+
+// Split streams: each format reads its own buffer, locations continue from
+// one format to the next. Positions alone in one stream keep passes that
+// only need positions (picking, depth) from fetching the rest.
+//
+//   VertexStreams<VertexFormat<Half2>, VertexFormat<UByte4Norm> >::setup(buffers);
+template<typename... Formats>
+struct VertexStreams;
+
+template<>
+struct VertexStreams<> {
+	static const unsigned int count = 0;
+
+	static void setup(const unsigned int *, unsigned int = 0) {
+	}
+};
+
+template<typename First, typename... Rest>
+struct VertexStreams<First, Rest...> {
+	static const unsigned int count = First::count + VertexStreams<Rest...>::count;
+
+	static void setup(const unsigned int *buffers, unsigned int firstLocation = 0) {
+		First::setup(buffers[0], firstLocation);
+		VertexStreams<Rest...>::setup(buffers + 1, firstLocation + First::count);
+	}
+};
+
+// packing for the compact attribute types ---------------------------------
+
+// IEEE half, rounded to nearest; overflow goes to infinity, tiny values to 0
+inline unsigned short halfFromFloat(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, 4);
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (((bits >> 23) & 0xFF) == 0xFF)
+		return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+	if (exponent >= 31)
+		return sign | 0x7C00;
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		uint32_t half = mantissa >> shift;
+		if ((mantissa >> (shift - 1)) & 1)
+			half++;
+		return sign | half;
+	}
+
+	uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+	if (mantissa & 0x1000)
+		half++;   //carries into the exponent correctly
+	return half;
+}
+
+// [-1,1] -> int16 as c = value * 32767. GL 4.2+ reads a normalized GL_SHORT
+// back as c / 32767, exact for 0 and +-1; GL 3.3 reads (2c + 1) / 65535,
+// which is off by up to 1/65535 and never gives exactly 0
+inline short snorm16(float value) {
+	value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+	return (short)std::lround(value * 32767.0f);
+}
+
+// [0,1] -> uint8, as GL_UNSIGNED_BYTE normalized reads it back
+inline unsigned char unorm8(float value) {
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (unsigned char)std::lround(value * 255.0f);
+}